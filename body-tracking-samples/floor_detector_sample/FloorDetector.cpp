@@ -3,9 +3,8 @@
 
 #include "FloorDetector.h"
 
-#include <algorithm>    // std::sort
+#include <algorithm>    // std::min, std::max
 #include <cassert>      // assert
-#include <numeric>      // std::iota
 
 std::optional<Samples::Vector> Samples::TryEstimateGravityVectorForDepthCamera(
     const k4a_imu_sample_t& imuSample,
@@ -37,67 +36,219 @@ std::optional<Samples::Vector> Samples::TryEstimateGravityVectorForDepthCamera(
     return {};
 }
 
-struct HistogramBin
+// First and second moments of a set of points, enough to fit a plane to the points without keeping them.
+// Accumulated in double since the covariance is computed as the difference of large sums.
+struct PointMoments
 {
-    size_t count;
-    float leftEdge;
+    size_t count = 0;
+    double x = 0, y = 0, z = 0;
+    double xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+
+    void Add(const k4a_float3_t& p)
+    {
+        const double px = p.xyz.x;
+        const double py = p.xyz.y;
+        const double pz = p.xyz.z;
+        count++;
+        x += px;
+        y += py;
+        z += pz;
+        xx += px * px;
+        xy += px * py;
+        xz += px * pz;
+        yy += py * py;
+        yz += py * pz;
+        zz += pz * pz;
+    }
+
+    PointMoments& operator+=(const PointMoments& other)
+    {
+        count += other.count;
+        x += other.x;
+        y += other.y;
+        z += other.z;
+        xx += other.xx;
+        xy += other.xy;
+        xz += other.xz;
+        yy += other.yy;
+        yz += other.yz;
+        zz += other.zz;
+        return *this;
+    }
+
+    // Moments of the same points moved by t.
+    PointMoments Translated(const Samples::Vector& t) const
+    {
+        const double n = static_cast<double>(count);
+        PointMoments result = *this;
+        result.x += n * t.X;
+        result.y += n * t.Y;
+        result.z += n * t.Z;
+        result.xx += 2 * t.X * x + n * t.X * t.X;
+        result.xy += t.X * y + t.Y * x + n * t.X * t.Y;
+        result.xz += t.X * z + t.Z * x + n * t.X * t.Z;
+        result.yy += 2 * t.Y * y + n * t.Y * t.Y;
+        result.yz += t.Y * z + t.Z * y + n * t.Y * t.Z;
+        result.zz += 2 * t.Z * z + n * t.Z * t.Z;
+        return result;
+    }
+
+    PointMoments operator-(const PointMoments& other) const
+    {
+        PointMoments result = *this;
+        result.count -= other.count;
+        result.x -= other.x;
+        result.y -= other.y;
+        result.z -= other.z;
+        result.xx -= other.xx;
+        result.xy -= other.xy;
+        result.xz -= other.xz;
+        result.yy -= other.yy;
+        result.yz -= other.yz;
+        result.zz -= other.zz;
+        return result;
+    }
 };
 
-std::vector<HistogramBin> Histogram(const std::vector<float>& values, float binSize)
+// Histogram of point elevations where every bin holds the moments of its points instead of just their count.
+struct Samples::ElevationHistogram
 {
-    // Bounds
-    const auto [minEl, maxEl] = std::minmax_element(values.begin(), values.end());
-    const float minVal = *minEl;
-    const float maxVal = *maxEl;
+    // Elevations are binned from -MaxElevationInMeters to MaxElevationInMeters. No point of the depth camera is that far
+    // from it: the longest depth range, 5.46 m in NFOV 2x2 binned mode, is under 8 m away at the corners of the field
+    // of view.
+    static constexpr float MaxElevationInMeters = 8.0f;
 
-    size_t binCount = 1 + static_cast<size_t>((maxVal - minVal) / binSize);
+    float binSize = 0;
+    std::vector<PointMoments> bins;
 
-    // Bins
-    std::vector<HistogramBin> histBins{ binCount };
-    for (size_t i = 0; i < binCount; ++i)
+    // Range of the bins that hold at least one point.
+    size_t lowestBin = 0;
+    size_t highestBin = 0;
+
+    // Empties the histogram. The bins are allocated by the first call only, later calls clear the bins that held points,
+    // so a histogram that is reused from frame to frame does not touch its empty bins.
+    void Reset(float binSizeInMeters)
     {
-        histBins[i] = { /*binCount*/ 0, /*binLeftEdge*/ i * binSize + minVal };
+        if (binSizeInMeters != binSize)
+        {
+            binSize = binSizeInMeters;
+            bins.assign(static_cast<size_t>(2 * MaxElevationInMeters / binSize) + 1, PointMoments{});
+        }
+        else if (lowestBin <= highestBin)
+        {
+            std::fill(bins.begin() + lowestBin, bins.begin() + highestBin + 1, PointMoments{});
+        }
+        lowestBin = bins.size();
+        highestBin = 0;
     }
 
-    // Counts
-    for (float v : values)
+    // Bins the elevations of cloudPoints[begin, end) and accumulates their moments in a single pass.
+    void Add(const std::vector<k4a_float3_t>& cloudPoints, const std::vector<float>& elevations, size_t begin, size_t end)
     {
-        int binIndex = static_cast<int>((v - minVal) / binSize);
-        histBins[binIndex].count++;
+        // The loop works on local copies, the stores to the bins could otherwise alias the members.
+        PointMoments* binData = bins.data();
+        const float firstElevation = -MaxElevationInMeters;
+        const float binSizeInMeters = binSize;
+        const float maxBinIndex = static_cast<float>(bins.size()) - 1;
+        size_t lowest = lowestBin;
+        size_t highest = highestBin;
+        for (size_t i = begin; i < end; ++i)
+        {
+            // Elevation of the point relative to the first bin.
+            float binPosition = (elevations[i] - firstElevation) / binSizeInMeters;
+            if (!(binPosition >= 0 && binPosition <= maxBinIndex))
+            {
+                continue;
+            }
+
+            size_t binIndex = static_cast<size_t>(binPosition);
+            binData[binIndex].Add(cloudPoints[i]);
+            lowest = std::min(lowest, binIndex);
+            highest = std::max(highest, binIndex);
+        }
+        lowestBin = lowest;
+        highestBin = highest;
     }
-    return histBins;
-}
+};
 
-std::optional<Samples::Plane> FitPlaneToInlierPoints(const std::vector<k4a_float3_t>& cloudPoints, const std::vector<size_t>& inlierIndices)
+Samples::FloorDetector::FloorDetector() = default;
+Samples::FloorDetector::~FloorDetector() = default;
+
+const Samples::ElevationHistogram& Samples::FloorDetector::ComputeElevationHistogram(
+    const std::vector<k4a_float3_t>& cloudPoints,
+    const std::vector<float>& elevations,
+    float binSize,
+    const ParallelOptions& parallelOptions)
 {
-    // https://www.ilikebigbits.com/2015_03_04_plane_from_points.html
+    size_t partitionCount = 1;
+    if (parallelOptions.Pool != nullptr && cloudPoints.size() >= parallelOptions.MinimumPointCount)
+    {
+        partitionCount = parallelOptions.Pool->GetThreadCount();
+    }
 
-    if (inlierIndices.size() < 3)
+    // One scratch histogram per partition, kept from call to call.
+    if (m_histograms.size() < partitionCount)
     {
-        return {};
+        m_histograms.resize(partitionCount);
+    }
+    for (size_t partition = 0; partition < partitionCount; ++partition)
+    {
+        m_histograms[partition].Reset(binSize);
     }
 
-    // Compute centroid.
-    Samples::Vector centroid(0, 0, 0);
-    for (const auto& index : inlierIndices)
+    ElevationHistogram& histogram = m_histograms[0];
+    if (partitionCount == 1)
+    {
+        histogram.Add(cloudPoints, elevations, 0, cloudPoints.size());
+        return histogram;
+    }
+
+    parallelOptions.Pool->Run(partitionCount, [&](size_t partition) {
+        size_t begin = cloudPoints.size() * partition / partitionCount;
+        size_t end = cloudPoints.size() * (partition + 1) / partitionCount;
+        m_histograms[partition].Add(cloudPoints, elevations, begin, end);
+    });
+
+    // Add the partitions in a fixed order, floating point sums depend on it.
+    for (size_t partition = 1; partition < partitionCount; ++partition)
     {
-        centroid = centroid + cloudPoints[index];
+        const ElevationHistogram& partial = m_histograms[partition];
+        for (size_t binIndex = partial.lowestBin; binIndex <= partial.highestBin; ++binIndex)
+        {
+            histogram.bins[binIndex] += partial.bins[binIndex];
+        }
+
+        // An empty partition has its lowest bin above its highest bin.
+        if (partial.lowestBin <= partial.highestBin)
+        {
+            histogram.lowestBin = std::min(histogram.lowestBin, partial.lowestBin);
+            histogram.highestBin = std::max(histogram.highestBin, partial.highestBin);
+        }
     }
-    centroid = centroid / static_cast<float>(inlierIndices.size());
+    return histogram;
+}
+
+std::optional<Samples::Plane> FitPlaneToMoments(const PointMoments& moments)
+{
+    // https://www.ilikebigbits.com/2015_03_04_plane_from_points.html
 
-    // Compute the zero-mean 3x3 symmetric covariance matrix relative.
-    float xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
-    for (const auto& index : inlierIndices)
+    if (moments.count < 3)
     {
-        Samples::Vector r = cloudPoints[index] - centroid;
-        xx += r.X * r.X;
-        xy += r.X * r.Y;
-        xz += r.X * r.Z;
-        yy += r.Y * r.Y;
-        yz += r.Y * r.Z;
-        zz += r.Z * r.Z;
+        return {};
     }
 
+    // Compute centroid.
+    const double n = static_cast<double>(moments.count);
+    Samples::Vector centroid(static_cast<float>(moments.x / n), static_cast<float>(moments.y / n), static_cast<float>(moments.z / n));
+
+    // Compute the zero-mean 3x3 symmetric covariance matrix relative to the centroid from the raw moments.
+    float xx = static_cast<float>(moments.xx - moments.x * moments.x / n);
+    float xy = static_cast<float>(moments.xy - moments.x * moments.y / n);
+    float xz = static_cast<float>(moments.xz - moments.x * moments.z / n);
+    float yy = static_cast<float>(moments.yy - moments.y * moments.y / n);
+    float yz = static_cast<float>(moments.yz - moments.y * moments.z / n);
+    float zz = static_cast<float>(moments.zz - moments.z * moments.z / n);
+
     float detX = yy * zz - yz * yz;
     float detY = xx * zz - xz * xz;
     float detZ = xx * yy - xy * xy;
@@ -125,6 +276,69 @@ std::optional<Samples::Plane> FitPlaneToInlierPoints(const std::vector<k4a_float
     return Samples::Plane::Create(normal.Normalized(), centroid);
 }
 
+// There could be several horizontal planes in the scene (floor, tables, ceiling).
+// For the floor, look for lowest N points whose elevations are within a small range from each other.
+const float PlaneDisplacementRangeInMeters = 0.050f; // 5 cm in meters.
+const float PlaneMaxTiltInDeg = 5.0f;
+
+const int BinAggregation = 6;
+const float BinSize = PlaneDisplacementRangeInMeters / BinAggregation;
+
+std::optional<Samples::Plane> TryDetectFloorPlaneInHistogram(
+    const Samples::ElevationHistogram& histogram,
+    const Samples::Vector& up,
+    size_t minimumFloorPointCount)
+{
+    static_assert(BinAggregation >= 1, "A window needs at least one bin");
+    if (histogram.lowestBin > histogram.highestBin)
+    {
+        return {};
+    }
+
+    // Cumulative moments of the occupied bins.
+    const size_t binCount = histogram.highestBin - histogram.lowestBin + 1;
+    std::vector<PointMoments> cumulativeMoments(binCount);
+    cumulativeMoments[0] = histogram.bins[histogram.lowestBin];
+    for (size_t i = 1; i < binCount; ++i)
+    {
+        cumulativeMoments[i] = cumulativeMoments[i - 1];
+        cumulativeMoments[i] += histogram.bins[histogram.lowestBin + i];
+    }
+
+    for (size_t i = 1; i + BinAggregation < binCount; ++i)
+    {
+        size_t aggBinStart = i;                 // inclusive bin
+        size_t aggBinEnd = i + BinAggregation;  // exclusive bin
+        size_t inlierCount = cumulativeMoments[aggBinEnd - 1].count - cumulativeMoments[aggBinStart - 1].count;
+        if (inlierCount > minimumFloorPointCount)
+        {
+            // Fit plane to inlier points.
+            auto refinedPlane = FitPlaneToMoments(cumulativeMoments[aggBinEnd - 1] - cumulativeMoments[aggBinStart - 1]);
+
+            if (refinedPlane.has_value())
+            {
+                // Ensure normal is upward.
+                if (refinedPlane->Normal.Dot(up) < 0)
+                {
+                    refinedPlane->Normal = refinedPlane->Normal * -1;
+                }
+
+                // Ensure normal is mostly vertical.
+                auto floorTiltInDeg = acos(refinedPlane->Normal.Dot(up)) * 180.0f / 3.14159265f;
+                if (floorTiltInDeg < PlaneMaxTiltInDeg)
+                {
+                    // For reduced jitter, use gravity for floor normal.
+                    return Samples::Plane::Create(up, refinedPlane->Origin);
+                }
+            }
+
+            return {};
+        }
+    }
+
+    return {};
+}
+
 std::optional<Samples::Plane> Samples::FloorDetector::TryDetectFloorPlane(
     const std::vector<k4a_float3_t>& cloudPoints,
     const k4a_imu_sample_t& imuSample,
@@ -137,79 +351,258 @@ std::optional<Samples::Plane> Samples::FloorDetector::TryDetectFloorPlane(
         // Up normal is opposite to gravity down vector.
         Samples::Vector up = (gravity.value() * -1).Normalized();
 
-        // Compute elevation of cloud points (projections on the floor normal).
-        std::vector<float> offsets(cloudPoints.size());
+        // The elevations are computed once, the plane is then fit to the moments of the winning bins, so the points
+        // are not visited again.
+        std::vector<float> elevations(cloudPoints.size());
         for (size_t i = 0; i < cloudPoints.size(); ++i)
         {
-            offsets[i] = up.Dot(Samples::Vector(cloudPoints[i]));
+            elevations[i] = up.Dot(Samples::Vector(cloudPoints[i]));
+        }
+
+        FloorDetector floorDetector;
+        return floorDetector.TryDetectFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount);
+    }
+
+    return {};
+}
+
+std::optional<Samples::Plane> Samples::FloorDetector::TryDetectFloorPlane(
+    const std::vector<k4a_float3_t>& cloudPoints,
+    const std::vector<float>& elevations,
+    const Samples::Vector& up,
+    size_t minimumFloorPointCount,
+    const ParallelOptions& parallelOptions)
+{
+    assert(elevations.size() == cloudPoints.size());
+    if (cloudPoints.empty())
+    {
+        return {};
+    }
+
+    const auto& histogram = ComputeElevationHistogram(cloudPoints, elevations, BinSize, parallelOptions);
+    return TryDetectFloorPlaneInHistogram(histogram, up, minimumFloorPointCount);
+}
+
+// Spread of the points of moments along the directions a and b: the mean of (a.p)(b.p) minus (a.centroid)(b.centroid).
+double GetCovarianceAlong(const PointMoments& moments, const Samples::Vector& a, const Samples::Vector& b)
+{
+    const double n = static_cast<double>(moments.count);
+    double meanA = (a.X * moments.x + a.Y * moments.y + a.Z * moments.z) / n;
+    double meanB = (b.X * moments.x + b.Y * moments.y + b.Z * moments.z) / n;
+    double productSum =
+        a.X * b.X * moments.xx + a.Y * b.Y * moments.yy + a.Z * b.Z * moments.zz +
+        (a.X * b.Y + a.Y * b.X) * moments.xy +
+        (a.X * b.Z + a.Z * b.X) * moments.xz +
+        (a.Y * b.Z + a.Z * b.Y) * moments.yz;
+    return productSum / n - meanA * meanB;
+}
+
+// Plane through the inliers with the given fitted normal, and their horizontal extent from the principal directions
+// of their horizontal spread.
+Samples::HorizontalPlane CreateHorizontalPlane(const Samples::Plane& fittedPlane, const PointMoments& moments, const Samples::Vector& up)
+{
+    // Any two horizontal directions.
+    Samples::Vector reference = std::abs(up.X) < 0.9f ? Samples::Vector(1, 0, 0) : Samples::Vector(0, 1, 0);
+    Samples::Vector e1 = (reference - up * up.Dot(reference)).Normalized();
+    Samples::Vector e2 = up * e1;
+
+    // Eigen decomposition of the 2x2 covariance matrix in the (e1, e2) basis.
+    double a = GetCovarianceAlong(moments, e1, e1);
+    double b = GetCovarianceAlong(moments, e1, e2);
+    double d = GetCovarianceAlong(moments, e2, e2);
+    double halfTrace = (a + d) / 2;
+    double radius = std::sqrt((a - d) * (a - d) / 4 + b * b);
+    double angle = std::atan2(2 * b, a - d) / 2;
+
+    Samples::Vector majorAxis = e1 * static_cast<float>(std::cos(angle)) + e2 * static_cast<float>(std::sin(angle));
+
+    // A uniform segment of length L has a variance of L^2 / 12.
+    return {
+        Samples::Plane::Create(fittedPlane.Normal, fittedPlane.Origin),
+        up.Dot(fittedPlane.Origin),
+        moments.count,
+        majorAxis,
+        up * majorAxis,
+        static_cast<float>(std::sqrt(12 * std::max(halfTrace + radius, 0.0))),
+        static_cast<float>(std::sqrt(12 * std::max(halfTrace - radius, 0.0))) };
+}
+
+std::vector<Samples::HorizontalPlane> Samples::FloorDetector::DetectHorizontalPlanes(
+    const std::vector<k4a_float3_t>& cloudPoints,
+    const std::vector<float>& elevations,
+    const Samples::Vector& up,
+    size_t minimumPlanePointCount,
+    const ParallelOptions& parallelOptions)
+{
+    assert(elevations.size() == cloudPoints.size());
+    std::vector<HorizontalPlane> planes;
+
+    const auto& histogram = ComputeElevationHistogram(cloudPoints, elevations, BinSize, parallelOptions);
+    if (histogram.lowestBin > histogram.highestBin)
+    {
+        return planes;
+    }
+
+    // cumulativeMoments[i] holds the moments of the first i occupied bins, so the moments of any window of bins are
+    // the difference of two entries.
+    const size_t binCount = histogram.highestBin - histogram.lowestBin + 1;
+    std::vector<PointMoments> cumulativeMoments(binCount + 1);
+    for (size_t i = 0; i < binCount; ++i)
+    {
+        cumulativeMoments[i + 1] = cumulativeMoments[i];
+        cumulativeMoments[i + 1] += histogram.bins[histogram.lowestBin + i];
+    }
+    auto getWindowMoments = [&](ptrdiff_t start) {
+        if (start < 0 || start + BinAggregation > static_cast<ptrdiff_t>(binCount))
+        {
+            return PointMoments{};
+        }
+        return cumulativeMoments[start + BinAggregation] - cumulativeMoments[start];
+    };
+    auto getWindowCount = [&](ptrdiff_t start) { return getWindowMoments(start).count; };
+
+    const float maxTiltCosine = std::cos(PlaneMaxTiltInDeg * 3.14159265f / 180.0f);
+    for (ptrdiff_t start = 0; start + BinAggregation <= static_cast<ptrdiff_t>(binCount); ++start)
+    {
+        const size_t windowCount = getWindowCount(start);
+        if (windowCount <= minimumPlanePointCount)
+        {
+            continue;
         }
 
-        // There could be several horizontal planes in the scene (floor, tables, ceiling).
-        // For the floor, look for lowest N points whose elevations are within a small range from each other.
+        // A surface fills several overlapping windows, only the one with the most points is kept.
+        bool isPeak = true;
+        for (ptrdiff_t other = start - BinAggregation; other <= start + BinAggregation && isPeak; ++other)
+        {
+            size_t otherCount = getWindowCount(other);
+            isPeak = otherCount < windowCount || (otherCount == windowCount && other >= start);
+        }
+        if (!isPeak)
+        {
+            continue;
+        }
 
-        const float planeDisplacementRangeInMeters = 0.050f; // 5 cm in meters.
-        const float planeMaxTiltInDeg = 5.0f;
+        // Walls and other vertical structures add about the same points to every window. Their share is estimated
+        // from the emptier of the windows right below and right above, moved to the elevation of this window, and
+        // removed from the moments of the surface.
+        const Samples::Vector windowHeight = up * (BinAggregation * BinSize);
+        const PointMoments below = getWindowMoments(start - BinAggregation);
+        const PointMoments above = getWindowMoments(start + BinAggregation);
+        const PointMoments background = below.count < above.count ? below.Translated(windowHeight) : above.Translated(windowHeight * -1);
+        const PointMoments inliers = getWindowMoments(start) - background;
+        if (inliers.count <= minimumPlanePointCount)
+        {
+            continue;
+        }
 
-        const int binAggregation = 6;
-        assert(binAggregation >= 1);
-        const float binSize = planeDisplacementRangeInMeters / binAggregation;
-        const auto histBins = Histogram(offsets, binSize);
-        
-        // Cumulative histogram counts.
-        std::vector<size_t> cumulativeHistCounts(histBins.size());
-        cumulativeHistCounts[0] = histBins[0].count;
-        for (size_t i = 1; i < histBins.size(); ++i)
+        // Vertical structures alone have a horizontal fitted normal.
+        auto fittedPlane = FitPlaneToMoments(inliers);
+        if (fittedPlane.has_value() && fittedPlane->Normal.Dot(up) < 0)
+        {
+            fittedPlane->Normal = fittedPlane->Normal * -1;
+        }
+        if (fittedPlane.has_value() && fittedPlane->Normal.Dot(up) >= maxTiltCosine)
         {
-            cumulativeHistCounts[i] = cumulativeHistCounts[i - 1] + histBins[i].count;
+            planes.push_back(CreateHorizontalPlane(fittedPlane.value(), inliers, up));
         }
+    }
+
+    return planes;
+}
 
-        assert(cumulativeHistCounts.back() == offsets.size());
+// Temporal tracking parameters.
+const size_t TrackingSampleCount = 1024;
+const size_t TrackingMinimumInlierSampleCount = 32;
+const float TrackingMaxUpChangeInDeg = 1.0f;
+const float TrackingElevationSmoothing = 0.1f; // Weight of the current frame in the tracked floor elevation.
 
-        for (size_t i = 1; i + binAggregation < cumulativeHistCounts.size(); ++i)
+std::optional<Samples::Plane> Samples::FloorDetector::TrackFloorPlane(
+    const std::vector<k4a_float3_t>& cloudPoints,
+    const std::vector<float>& elevations,
+    const Samples::Vector& up,
+    size_t minimumFloorPointCount,
+    const ParallelOptions& parallelOptions)
+{
+    if (m_isTracking)
+    {
+        auto trackedPlane = TryTrackPreviousFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount);
+        if (trackedPlane.has_value())
         {
-            size_t aggBinStart = i;                 // inclusive bin
-            size_t aggBinEnd = i + binAggregation;  // exclusive bin
-            size_t inlierCount = cumulativeHistCounts[aggBinEnd - 1] - cumulativeHistCounts[aggBinStart - 1];
-            if (inlierCount > minimumFloorPointCount)
-            {
-                float offsetStart = histBins[aggBinStart].leftEdge; // inclusive
-                float offsetEnd = histBins[aggBinEnd].leftEdge;     // exclusive
+            return trackedPlane;
+        }
+    }
 
-                // Inlier indices.
-                std::vector<size_t> inlierIndices;
-                for (size_t j = 0; j < offsets.size(); ++j)
-                {
-                    if (offsetStart <= offsets[j] && offsets[j] < offsetEnd)
-                    {
-                        inlierIndices.push_back(j);
-                    }
-                }
+    auto floorPlane = TryDetectFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions);
+    m_isTracking = floorPlane.has_value();
+    if (m_isTracking)
+    {
+        // The normal of a detected floor is up, so its elevation is -C.
+        m_trackedUp = up;
+        m_trackedFloorElevation = -floorPlane->C;
+    }
+    return floorPlane;
+}
 
-                // Fit plane to inlier points.
-                auto refinedPlane = FitPlaneToInlierPoints(cloudPoints, inlierIndices);
+void Samples::FloorDetector::ResetTracking()
+{
+    m_isTracking = false;
+}
 
-                if (refinedPlane.has_value())
-                {
-                    // Ensure normal is upward.
-                    if (refinedPlane->Normal.Dot(up) < 0)
-                    {
-                        refinedPlane->Normal = refinedPlane->Normal * -1;
-                    }
-
-                    // Ensure normal is mostly vertical.
-                    auto floorTiltInDeg = acos(refinedPlane->Normal.Dot(up)) * 180.0f / 3.14159265f;
-                    if (floorTiltInDeg < planeMaxTiltInDeg)
-                    {
-                        // For reduced jitter, use gravity for floor normal.
-                        refinedPlane->Normal = up;
-                        return refinedPlane;
-                    }
-                }
+std::optional<Samples::Plane> Samples::FloorDetector::TryTrackPreviousFloorPlane(
+    const std::vector<k4a_float3_t>& cloudPoints,
+    const std::vector<float>& elevations,
+    const Samples::Vector& up,
+    size_t minimumFloorPointCount)
+{
+    assert(elevations.size() == cloudPoints.size());
 
-                return {};
-            }
+    // A rotation of the device changes the elevation of every point, the previous floor is not valid anymore.
+    if (cloudPoints.empty() || std::min(up.Dot(m_trackedUp), 1.0f) < std::cos(TrackingMaxUpChangeInDeg * 3.14159265f / 180.0f))
+    {
+        return {};
+    }
+
+    // Classify a random subset of the points against the same elevation range as the floor search.
+    const size_t sampleCount = std::min(TrackingSampleCount, cloudPoints.size());
+    std::uniform_int_distribution<size_t> pointIndex(0, cloudPoints.size() - 1);
+
+    const float floorBottom = m_trackedFloorElevation - PlaneDisplacementRangeInMeters / 2;
+    const float floorTop = m_trackedFloorElevation + PlaneDisplacementRangeInMeters / 2;
+    size_t belowCount = 0;
+    PointMoments inliers;
+    double inlierElevationSum = 0;
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        size_t index = sampleCount == cloudPoints.size() ? i : pointIndex(m_random);
+        float elevation = elevations[index];
+        if (elevation < floorBottom)
+        {
+            belowCount++;
+        }
+        else if (elevation <= floorTop)
+        {
+            inliers.Add(cloudPoints[index]);
+            inlierElevationSum += elevation;
         }
     }
 
-    return {};
+    // Estimated number of points in the whole cloud. The floor must still hold enough of them, and there must not be a
+    // lower structure that the full search would pick as the floor instead.
+    const float sampleToCloud = static_cast<float>(cloudPoints.size()) / sampleCount;
+    if (inliers.count < TrackingMinimumInlierSampleCount ||
+        inliers.count * sampleToCloud <= minimumFloorPointCount ||
+        belowCount * sampleToCloud > minimumFloorPointCount)
+    {
+        return {};
+    }
+
+    // Move the floor elevation slowly towards the current frame to reduce jitter.
+    float measuredElevation = static_cast<float>(inlierElevationSum / inliers.count);
+    m_trackedFloorElevation += TrackingElevationSmoothing * (measuredElevation - m_trackedFloorElevation);
+
+    // Origin at the center of the inliers, moved along up onto the tracked elevation.
+    const double n = static_cast<double>(inliers.count);
+    Samples::Vector centroid(static_cast<float>(inliers.x / n), static_cast<float>(inliers.y / n), static_cast<float>(inliers.z / n));
+    Samples::Vector origin = centroid + up * (m_trackedFloorElevation - up.Dot(centroid));
+    return Samples::Plane::Create(up, origin);
 }
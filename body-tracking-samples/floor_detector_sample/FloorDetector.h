@@ -4,8 +4,10 @@
 #pragma once
 
 #include "SampleMathTypes.h"
+#include "ThreadPool.h"
 
 #include <optional>
+#include <random>
 #include <vector>
 
 namespace Samples
@@ -14,13 +16,107 @@ namespace Samples
         const k4a_imu_sample_t& imuSample,
         const k4a_calibration_t& sensorCalibration);
 
+    // Splits the elevation histogram of large clouds across the threads of Pool. Every thread bins a contiguous range
+    // of the points and the partial histograms are added in range order, so the result only depends on the number of
+    // threads of the pool, not on their scheduling. Clouds with fewer than MinimumPointCount points are binned on the
+    // calling thread, since waking up the pool costs more than it saves for them.
+    struct ParallelOptions
+    {
+        ThreadPool* Pool = nullptr;
+        size_t MinimumPointCount = 100000;
+    };
+
+    // Horizontal surface found by FloorDetector::DetectHorizontalPlanes().
+    struct HorizontalPlane
+    {
+        // Plane fitted to the inlier points, through their centroid, with its normal pointing up.
+        Samples::Plane Plane;
+
+        // Elevation of the centroid along up.
+        float Elevation;
+
+        size_t InlierCount;
+
+        // Horizontal extent of the inliers, as the rectangle with the same spread: MajorAxis and MinorAxis are its
+        // horizontal directions and MajorLength and MinorLength its side lengths. A full rectangle of points gives back
+        // its own size, a partly occluded surface gives the size of its visible part.
+        Samples::Vector MajorAxis;
+        Samples::Vector MinorAxis;
+        float MajorLength;
+        float MinorLength;
+    };
+
+    struct ElevationHistogram;
+
     class FloorDetector
     {
     public:
+        FloorDetector();
+        ~FloorDetector();
+
         static std::optional<Samples::Plane> TryDetectFloorPlane(
             const std::vector<k4a_float3_t>& cloudPoints,
             const k4a_imu_sample_t& imuSample,
             const k4a_calibration_t& sensorCalibration,
             size_t minimumFloorPointCount);
+
+        // Same as above for a gravity-aligned up vector that is already known, with the elevation of every cloud
+        // point along up, e.g. from PointCloudGenerator::GetCloudPoints(up, downsampleStep). The elevation histogram
+        // is kept in the detector and reused by the next call.
+        std::optional<Samples::Plane> TryDetectFloorPlane(
+            const std::vector<k4a_float3_t>& cloudPoints,
+            const std::vector<float>& elevations,
+            const Samples::Vector& up,
+            size_t minimumFloorPointCount,
+            const ParallelOptions& parallelOptions = {});
+
+        // Every horizontal surface with more than minimumPlanePointCount points within the elevation range of the floor
+        // search, e.g. the floor, tables and steps, sorted by increasing elevation. Uses the same single pass elevation
+        // histogram as TryDetectFloorPlane(), the planes are fit to the moments of the histogram bins.
+        std::vector<HorizontalPlane> DetectHorizontalPlanes(
+            const std::vector<k4a_float3_t>& cloudPoints,
+            const std::vector<float>& elevations,
+            const Samples::Vector& up,
+            size_t minimumPlanePointCount,
+            const ParallelOptions& parallelOptions = {});
+
+        // Temporal tracking of the floor for a device that mostly stays still. The floor plane of the previous frame
+        // is tested against a random subset of the cloud points and kept, with its elevation smoothed over frames,
+        // while enough of them still lie on it. The full search of TryDetectFloorPlane() only runs when the test
+        // fails or when up has moved since the plane was found.
+        std::optional<Samples::Plane> TrackFloorPlane(
+            const std::vector<k4a_float3_t>& cloudPoints,
+            const std::vector<float>& elevations,
+            const Samples::Vector& up,
+            size_t minimumFloorPointCount,
+            const ParallelOptions& parallelOptions = {});
+
+        // Forgets the tracked floor, e.g. when the IMU reports that the device is moving.
+        void ResetTracking();
+
+        // Whether the last TrackFloorPlane() found a floor, that the next one will try to keep.
+        bool IsTracking() const { return m_isTracking; }
+
+    private:
+        // Histogram of the elevations over the range of the depth camera. Large clouds are split across the thread pool,
+        // with one scratch histogram per partition.
+        const ElevationHistogram& ComputeElevationHistogram(
+            const std::vector<k4a_float3_t>& cloudPoints,
+            const std::vector<float>& elevations,
+            float binSize,
+            const ParallelOptions& parallelOptions);
+
+        std::optional<Samples::Plane> TryTrackPreviousFloorPlane(
+            const std::vector<k4a_float3_t>& cloudPoints,
+            const std::vector<float>& elevations,
+            const Samples::Vector& up,
+            size_t minimumFloorPointCount);
+
+        bool m_isTracking = false;
+        Samples::Vector m_trackedUp = { 0, 0, 0 };
+        float m_trackedFloorElevation = 0;
+        std::mt19937 m_random;
+
+        std::vector<ElevationHistogram> m_histograms;
     };
 }
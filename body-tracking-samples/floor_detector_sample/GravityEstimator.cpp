@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "GravityEstimator.h"
+
+#include <algorithm>    // std::copy, std::min
+#include <iostream>
+
+// Standard gravity in meters per second squared.
+const float GravityInMetersPerSecondSquared = 9.81f;
+
+// The first gravity estimate is only taken from an accelerometer at rest.
+const float RestAccelerationToleranceInMetersPerSecondSquared = 0.2f;
+
+// The accelerometer corrects the gravity estimate while it measures about 1g, which includes mild motion.
+const float CorrectionAccelerationToleranceInMetersPerSecondSquared = 1.0f;
+
+// Time for the accelerometer correction to remove most of the gyroscope drift.
+const float CorrectionTimeConstantInSeconds = 0.5f;
+
+// Above this rotation speed the device is moving, about 3 degrees per second.
+const float MovingAngularSpeedInRadiansPerSecond = 0.05f;
+
+// Longest gap between two samples that is integrated, e.g. after the IMU was restarted.
+const float MaxSampleIntervalInSeconds = 0.1f;
+
+const int ImuSampleTimeoutInMs = 10;
+
+Samples::Vector RotateToDepth(const float* rotation, const k4a_float3_t& v)
+{
+    Samples::Vector Rx = { rotation[0], rotation[1], rotation[2] };
+    Samples::Vector Ry = { rotation[3], rotation[4], rotation[5] };
+    Samples::Vector Rz = { rotation[6], rotation[7], rotation[8] };
+    Samples::Vector sample = v;
+    return { Rx.Dot(sample), Ry.Dot(sample), Rz.Dot(sample) };
+}
+
+Samples::GravityEstimator::GravityEstimator(const k4a_calibration_t& sensorCalibration)
+{
+    const auto& accelerometerToDepth = sensorCalibration.extrinsics[K4A_CALIBRATION_TYPE_ACCEL][K4A_CALIBRATION_TYPE_DEPTH].rotation;
+    const auto& gyroscopeToDepth = sensorCalibration.extrinsics[K4A_CALIBRATION_TYPE_GYRO][K4A_CALIBRATION_TYPE_DEPTH].rotation;
+    std::copy(std::begin(accelerometerToDepth), std::end(accelerometerToDepth), m_accelerometerToDepth);
+    std::copy(std::begin(gyroscopeToDepth), std::end(gyroscopeToDepth), m_gyroscopeToDepth);
+
+    for (auto& component : m_snapshotGravity)
+    {
+        component.store(0, std::memory_order_relaxed);
+    }
+}
+
+Samples::GravityEstimator::~GravityEstimator()
+{
+    Stop();
+}
+
+void Samples::GravityEstimator::Start(k4a_device_t device)
+{
+    Stop();
+    m_isRunning = true;
+    m_thread = std::thread(&GravityEstimator::ReadImuSamples, this, device);
+}
+
+void Samples::GravityEstimator::Stop()
+{
+    m_isRunning = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void Samples::GravityEstimator::ReadImuSamples(k4a_device_t device)
+{
+    while (m_isRunning)
+    {
+        // Returns immediately while samples are queued, so the queue is drained as fast as it fills.
+        k4a_imu_sample_t imuSample;
+        k4a_wait_result_t result = k4a_device_get_imu_sample(device, &imuSample, ImuSampleTimeoutInMs);
+        if (result == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            AddImuSample(imuSample);
+        }
+        else if (result != K4A_WAIT_RESULT_TIMEOUT)
+        {
+            std::cout << "Get IMU sample returned error: " << result << std::endl;
+            break;
+        }
+    }
+}
+
+void Samples::GravityEstimator::AddImuSample(const k4a_imu_sample_t& imuSample)
+{
+    // An accelerometer at rest measures an acceleration straight upwards, gravity is the opposite direction.
+    Samples::Vector acceleration = RotateToDepth(m_accelerometerToDepth, imuSample.acc_sample);
+    Samples::Vector angularVelocity = RotateToDepth(m_gyroscopeToDepth, imuSample.gyro_sample);
+    float accelerationError = std::abs(acceleration.Length() - GravityInMetersPerSecondSquared);
+
+    float interval = 0;
+    if (m_lastGyroscopeTimestampUsec != 0 && imuSample.gyro_timestamp_usec > m_lastGyroscopeTimestampUsec)
+    {
+        interval = std::min((imuSample.gyro_timestamp_usec - m_lastGyroscopeTimestampUsec) * 1e-6f, MaxSampleIntervalInSeconds);
+    }
+    m_lastGyroscopeTimestampUsec = imuSample.gyro_timestamp_usec;
+
+    if (!m_isInitialized)
+    {
+        if (accelerationError >= RestAccelerationToleranceInMetersPerSecondSquared)
+        {
+            return;
+        }
+        m_gravity = (acceleration * -1).Normalized();
+        m_isInitialized = true;
+    }
+    else
+    {
+        // Gravity is fixed in the world, so in camera coordinates it rotates opposite to the device:
+        // dg/dt = -w x g = g x w.
+        m_gravity = (m_gravity + (m_gravity * angularVelocity) * interval).Normalized();
+
+        if (accelerationError < CorrectionAccelerationToleranceInMetersPerSecondSquared)
+        {
+            float weight = interval / (CorrectionTimeConstantInSeconds + interval);
+            m_gravity = (m_gravity * (1 - weight) + (acceleration * -1).Normalized() * weight).Normalized();
+        }
+    }
+
+    GravitySnapshot snapshot;
+    snapshot.Gravity = m_gravity;
+    snapshot.IsValid = true;
+    snapshot.IsMoving = accelerationError >= RestAccelerationToleranceInMetersPerSecondSquared ||
+        angularVelocity.Length() > MovingAngularSpeedInRadiansPerSecond;
+    snapshot.TimestampUsec = imuSample.acc_timestamp_usec;
+    PublishSnapshot(snapshot);
+}
+
+void Samples::GravityEstimator::PublishSnapshot(const GravitySnapshot& snapshot)
+{
+    uint32_t sequence = m_snapshotSequence.load(std::memory_order_relaxed);
+    m_snapshotSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_snapshotGravity[0].store(snapshot.Gravity.X, std::memory_order_relaxed);
+    m_snapshotGravity[1].store(snapshot.Gravity.Y, std::memory_order_relaxed);
+    m_snapshotGravity[2].store(snapshot.Gravity.Z, std::memory_order_relaxed);
+    m_snapshotIsValid.store(snapshot.IsValid, std::memory_order_relaxed);
+    m_snapshotIsMoving.store(snapshot.IsMoving, std::memory_order_relaxed);
+    m_snapshotTimestampUsec.store(snapshot.TimestampUsec, std::memory_order_relaxed);
+
+    m_snapshotSequence.store(sequence + 2, std::memory_order_release);
+}
+
+Samples::GravitySnapshot Samples::GravityEstimator::GetSnapshot() const
+{
+    GravitySnapshot snapshot;
+    while (true)
+    {
+        uint32_t sequence = m_snapshotSequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0)
+        {
+            continue;
+        }
+
+        snapshot.Gravity = { m_snapshotGravity[0].load(std::memory_order_relaxed),
+            m_snapshotGravity[1].load(std::memory_order_relaxed),
+            m_snapshotGravity[2].load(std::memory_order_relaxed) };
+        snapshot.IsValid = m_snapshotIsValid.load(std::memory_order_relaxed);
+        snapshot.IsMoving = m_snapshotIsMoving.load(std::memory_order_relaxed);
+        snapshot.TimestampUsec = m_snapshotTimestampUsec.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_snapshotSequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return snapshot;
+        }
+    }
+}
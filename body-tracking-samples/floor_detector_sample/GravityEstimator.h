@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <k4a/k4a.h>
+
+#include "SampleMathTypes.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace Samples
+{
+    // Latest output of GravityEstimator.
+    struct GravitySnapshot
+    {
+        // Gravity direction in depth camera coordinates, a unit vector pointing down.
+        Samples::Vector Gravity = { 0, 0, 0 };
+
+        // False until the device has been at rest once.
+        bool IsValid = false;
+
+        // The device is rotating or accelerating, structures tracked over frames may have moved.
+        bool IsMoving = false;
+
+        uint64_t TimestampUsec = 0;
+    };
+
+    // Estimates gravity from the whole IMU stream with a complementary filter. The gyroscope rotates the gravity
+    // direction between samples, and the accelerometer slowly pulls it back towards the measured down direction
+    // whenever it is close to 1g, so the estimate stays valid during mild motion and does not drift.
+    //
+    // Start() reads the IMU samples of the device on a background thread, which keeps the IMU queue of the device
+    // empty. GetSnapshot() never blocks, it can be called from the capture loop at any time.
+    class GravityEstimator
+    {
+    public:
+        explicit GravityEstimator(const k4a_calibration_t& sensorCalibration);
+        ~GravityEstimator();
+
+        GravityEstimator(const GravityEstimator&) = delete;
+        GravityEstimator& operator=(const GravityEstimator&) = delete;
+
+        // The IMU of the device must be started. Stop() must be called before the IMU is stopped.
+        void Start(k4a_device_t device);
+        void Stop();
+
+        // Feeds one IMU sample to the filter. Called by the background thread, or directly for recorded samples.
+        void AddImuSample(const k4a_imu_sample_t& imuSample);
+
+        GravitySnapshot GetSnapshot() const;
+
+    private:
+        void ReadImuSamples(k4a_device_t device);
+        void PublishSnapshot(const GravitySnapshot& snapshot);
+
+        // Row-major rotations from the IMU sensors to the depth camera.
+        float m_accelerometerToDepth[9];
+        float m_gyroscopeToDepth[9];
+
+        // Filter state, only used by the thread that adds samples.
+        Samples::Vector m_gravity = { 0, 0, 0 };
+        bool m_isInitialized = false;
+        uint64_t m_lastGyroscopeTimestampUsec = 0;
+
+        // The snapshot is published with a sequence lock: the sequence is odd while it is written, and readers retry
+        // until they read it twice with the same even value around the copy.
+        std::atomic<uint32_t> m_snapshotSequence{ 0 };
+        std::atomic<float> m_snapshotGravity[3];
+        std::atomic<bool> m_snapshotIsValid{ false };
+        std::atomic<bool> m_snapshotIsMoving{ false };
+        std::atomic<uint64_t> m_snapshotTimestampUsec{ 0 };
+
+        std::thread m_thread;
+        std::atomic<bool> m_isRunning{ false };
+    };
+}
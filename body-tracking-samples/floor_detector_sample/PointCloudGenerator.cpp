@@ -6,94 +6,93 @@
 
 #include <k4a/k4a.h>
 
-
-// K4A SDK is currently missing a point cloud pixel type returned
-// by k4a_transformation_depth_image_to_point_cloud().
-typedef union
-{
-    /** XYZ or array representation of vector. */
-    struct _xyz
-    {
-        int16_t x; /**< X component of a vector. */
-        int16_t y; /**< Y component of a vector. */
-        int16_t z; /**< Z component of a vector. */
-    } xyz;         /**< X, Y, Z representation of a vector. */
-    int16_t v[3];    /**< Array representation of a vector. */
-} PointCloudPixel_int16x3_t;
-
-
 Samples::PointCloudGenerator::PointCloudGenerator(const k4a_calibration_t& sensorCalibration)
+    : m_unprojector(sensorCalibration)
 {
-    int depthWidth = sensorCalibration.depth_camera_calibration.resolution_width;
-    int depthHeight = sensorCalibration.depth_camera_calibration.resolution_height;
-
-    // Create transformation handle
-    m_transformationHandle = k4a_transformation_create(&sensorCalibration);
-
-    VERIFY(k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM,
-        depthWidth,
-        depthHeight,
-        depthWidth * (int)sizeof(PointCloudPixel_int16x3_t),
-        &m_pointCloudImage_int16x3), "Create Point Cloud Image failed!");
 }
 
 Samples::PointCloudGenerator::~PointCloudGenerator()
 {
-    if (m_transformationHandle != nullptr)
+    if (m_depthImage != nullptr)
     {
-        k4a_transformation_destroy(m_transformationHandle);
-        m_transformationHandle = nullptr;
+        k4a_image_release(m_depthImage);
+        m_depthImage = nullptr;
     }
+}
 
-    if (m_pointCloudImage_int16x3 != nullptr)
+void Samples::PointCloudGenerator::Update(k4a_image_t depthImage)
+{
+    EXIT_IF(k4a_image_get_width_pixels(depthImage) != m_unprojector.GetWidth() ||
+        k4a_image_get_height_pixels(depthImage) != m_unprojector.GetHeight(), "Depth image does not match the calibration!");
+
+    // The points are computed straight from the depth image, so only a reference to it is kept until the next frame.
+    k4a_image_reference(depthImage);
+    if (m_depthImage != nullptr)
     {
-        k4a_image_release(m_pointCloudImage_int16x3);
-        m_pointCloudImage_int16x3 = nullptr;
+        k4a_image_release(m_depthImage);
     }
+    m_depthImage = depthImage;
 }
 
-void Samples::PointCloudGenerator::Update(k4a_image_t depthImage)
+const uint16_t* Samples::PointCloudGenerator::GetDepthBuffer() const
 {
-    VERIFY(k4a_transformation_depth_image_to_point_cloud(
-        m_transformationHandle,
-        depthImage,
-        K4A_CALIBRATION_TYPE_DEPTH,
-        m_pointCloudImage_int16x3), "Transform depth image to point clouds failed!");
+    return reinterpret_cast<const uint16_t*>(k4a_image_get_buffer(m_depthImage));
 }
 
 const std::vector<k4a_float3_t>& Samples::PointCloudGenerator::GetCloudPoints(int step)
 {
-    int width = k4a_image_get_width_pixels(m_pointCloudImage_int16x3);
-    int height = k4a_image_get_height_pixels(m_pointCloudImage_int16x3);
+    PointCloudRegion region;
+    region.StepX = step;
+    region.StepY = step;
 
-    // Current SDK transforms a depth map to point cloud only as int16 type.
-    // The point cloud conversion below to float is relatively slow.
-    // It would be better for the SDK to provide this functionality directly.
+    m_cloudPoints.resize(m_unprojector.GetMaxPointCount(region));
+    size_t pointCount = m_unprojector.Unproject(GetDepthBuffer(), region, m_cloudPoints.data(), m_cloudPoints.size());
+    m_cloudPoints.resize(pointCount);
+    return m_cloudPoints;
+}
 
-    const auto pointCloudImageBufferInMM = (PointCloudPixel_int16x3_t*)k4a_image_get_buffer(m_pointCloudImage_int16x3);
+const std::vector<k4a_float3_t>& Samples::PointCloudGenerator::GetCloudPoints(const Samples::Vector& up, int step)
+{
+    PointCloudRegion region;
+    region.StepX = step;
+    region.StepY = step;
+    return GetCloudPoints(up, &region, 1);
+}
+
+const std::vector<k4a_float3_t>& Samples::PointCloudGenerator::GetCloudPoints(const Samples::Vector& up, const std::vector<PointCloudRegion>& regions)
+{
+    return GetCloudPoints(up, regions.data(), regions.size());
+}
+
+const std::vector<k4a_float3_t>& Samples::PointCloudGenerator::GetCloudPoints(const Samples::Vector& up, const PointCloudRegion* regions, size_t regionCount)
+{
+    // One entry per visited pixel, the invalid ones are dropped below.
+    size_t maxPointCount = 0;
+    for (size_t r = 0; r < regionCount; ++r)
+    {
+        maxPointCount += m_unprojector.GetMaxPointCount(regions[r]);
+    }
+    m_cloudPoints.resize(maxPointCount);
+    m_elevations.resize(maxPointCount);
 
-    m_cloudPoints.resize(width * height / (step * step));
-    size_t cloudPointsIndex = 0;
-    for (int h = 0; h < height; h+= step)
+    size_t pointCount = 0;
+    for (size_t r = 0; r < regionCount; ++r)
     {
-        for (int w = 0; w < width; w += step)
-        {
-            int pixelIndex = h * width + w;
-
-            // When the point cloud is invalid, the z-depth value is 0.
-            if (pointCloudImageBufferInMM[pixelIndex].xyz.z > 0)
-            {
-                const float MillimeterToMeter = 0.001f;
-                k4a_float3_t positionInMeter = {
-                    static_cast<float>(pointCloudImageBufferInMM[pixelIndex].v[0])* MillimeterToMeter,
-                    static_cast<float>(pointCloudImageBufferInMM[pixelIndex].v[1])* MillimeterToMeter,
-                    static_cast<float>(pointCloudImageBufferInMM[pixelIndex].v[2])* MillimeterToMeter };
-
-                m_cloudPoints[cloudPointsIndex++] = positionInMeter;
-            }
-        }
+        pointCount += m_unprojector.Unproject(GetDepthBuffer(), regions[r], { { up.X, up.Y, up.Z } },
+            m_cloudPoints.data() + pointCount, m_elevations.data() + pointCount, maxPointCount - pointCount);
     }
-    m_cloudPoints.resize(cloudPointsIndex);
 
+    m_cloudPoints.resize(pointCount);
+    m_elevations.resize(pointCount);
     return m_cloudPoints;
 }
+
+size_t Samples::PointCloudGenerator::GetMaxPointCount(const PointCloudRegion& region) const
+{
+    return m_unprojector.GetMaxPointCount(region);
+}
+
+size_t Samples::PointCloudGenerator::GetCloudPoints(const PointCloudRegion& region, const PointCloudArrays& points) const
+{
+    return m_unprojector.Unproject(GetDepthBuffer(), region, points);
+}
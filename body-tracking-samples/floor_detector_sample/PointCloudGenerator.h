@@ -5,6 +5,10 @@
 
 #include <k4a/k4atypes.h>
 
+#include "DepthUnprojector.h"
+#include "PointCloudBuffer.h"
+#include "SampleMathTypes.h"
+
 #include <vector>
 
 namespace Samples
@@ -15,12 +19,40 @@ namespace Samples
         PointCloudGenerator(const k4a_calibration_t& sensorCalibration);
         ~PointCloudGenerator();
 
+        // Keeps a reference to depthImage, the points are computed from it by GetCloudPoints().
         void Update(k4a_image_t depthImage);
         const std::vector<k4a_float3_t>& GetCloudPoints(int downsampleStep = 1);
 
+        // Same cloud points as GetCloudPoints(), and the elevation of every point along up (see GetElevations()),
+        // computed in a single pass over the depth image.
+        const std::vector<k4a_float3_t>& GetCloudPoints(const Samples::Vector& up, int downsampleStep = 1);
+        const std::vector<float>& GetElevations() const { return m_elevations; }
+
+        // Same as above for the points of several regions with their own sampling steps, one region after the other,
+        // e.g. from PointSampler::GetRegions(up).
+        const std::vector<k4a_float3_t>& GetCloudPoints(const Samples::Vector& up, const std::vector<PointCloudRegion>& regions);
+
+        // Most points GetCloudPoints(region, points) can return, the number of sampled pixels in region.
+        size_t GetMaxPointCount(const PointCloudRegion& region) const;
+
+        // Writes the valid points of region, in meters, to the caller-owned arrays of points and returns their count.
+        // Nothing is allocated, the arrays can be reused every frame and shared with other consumers. Size them with
+        // GetMaxPointCount(), e.g. with an AlignedPointCloudBuffer; the points that do not fit are left out.
+        size_t GetCloudPoints(const PointCloudRegion& region, const PointCloudArrays& points) const;
+
+        // Instruction set of the conversion, the best one supported by default.
+        void SetSimdLevel(SimdLevel level) { m_unprojector.SetSimdLevel(level); }
+
+        // Splits the conversion of large images across the threads of pool, see DepthUnprojector::SetThreadPool().
+        void SetThreadPool(ThreadPool* pool, size_t minimumPixelCount = 100000) { m_unprojector.SetThreadPool(pool, minimumPixelCount); }
+
     private:
-        k4a_transformation_t m_transformationHandle = nullptr;
-        k4a_image_t m_pointCloudImage_int16x3 = nullptr;
+        const uint16_t* GetDepthBuffer() const;
+        const std::vector<k4a_float3_t>& GetCloudPoints(const Samples::Vector& up, const PointCloudRegion* regions, size_t regionCount);
+
+        DepthUnprojector m_unprojector;
+        k4a_image_t m_depthImage = nullptr;
         std::vector<k4a_float3_t> m_cloudPoints;
+        std::vector<float> m_elevations;
     };
 }
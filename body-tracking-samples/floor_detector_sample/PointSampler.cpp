@@ -0,0 +1,187 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "PointSampler.h"
+#include "Utilities.h"
+
+#include <k4a/k4a.h>
+
+#include <algorithm>    // std::min, std::max
+#include <cmath>
+
+// The image is split into bands of rows that are sampled with their own steps.
+const int RowBandCount = 16;
+
+// Spacing of the pixels whose rays estimate the share of a band looking below the horizon.
+const int CoarseGridStep = 8;
+
+Samples::PointSampler::PointSampler(const k4a_calibration_t& sensorCalibration, const PointSamplingOptions& options)
+    : m_options(options)
+    , m_width(sensorCalibration.depth_camera_calibration.resolution_width)
+    , m_pointBudget(options.PointBudget)
+{
+    const int height = sensorCalibration.depth_camera_calibration.resolution_height;
+    const int bandCount = std::min(RowBandCount, height);
+    for (int b = 0; b < bandCount; ++b)
+    {
+        RowBand band;
+        band.Y = height * b / bandCount;
+        band.Height = height * (b + 1) / bandCount - band.Y;
+
+        size_t coarsePixelCount = 0;
+        for (int h = band.Y; h < band.Y + band.Height; h += CoarseGridStep)
+        {
+            for (int w = 0; w < m_width; w += CoarseGridStep)
+            {
+                k4a_float2_t pixel = { { static_cast<float>(w), static_cast<float>(h) } };
+                k4a_float3_t ray;
+                int valid = 0;
+                VERIFY(k4a_calibration_2d_to_3d(&sensorCalibration,
+                    &pixel,
+                    1.f,
+                    K4A_CALIBRATION_TYPE_DEPTH,
+                    K4A_CALIBRATION_TYPE_DEPTH,
+                    &ray,
+                    &valid), "Unproject depth pixel failed!");
+
+                coarsePixelCount++;
+                if (valid != 0)
+                {
+                    band.Rays.push_back(Samples::Vector(ray).Normalized());
+                }
+            }
+        }
+
+        // The valid pixels of the band, e.g. without the corners outside of the circular field of view of WFOV.
+        band.ValidPixelCount = static_cast<size_t>(m_width) * band.Height * band.Rays.size() / std::max<size_t>(coarsePixelCount, 1);
+        m_validPixelCount += band.ValidPixelCount;
+        m_bands.push_back(std::move(band));
+    }
+
+    m_downward.resize(m_bands.size());
+    m_weights.resize(m_bands.size());
+    m_shares.resize(m_bands.size());
+}
+
+const std::vector<Samples::PointCloudRegion>& Samples::PointSampler::GetRegions(const Samples::Vector& up)
+{
+    m_regions.clear();
+    if (m_options.Strategy == PointSamplingStrategy::FixedStep)
+    {
+        PointCloudRegion region;
+        region.StepX = std::max(m_options.DownsampleStep, 1);
+        region.StepY = region.StepX;
+        m_regions.push_back(region);
+        m_sampledRatio = 1.0f / (region.StepX * region.StepY);
+        m_floorSampledRatio = m_sampledRatio;
+        return m_regions;
+    }
+
+    // Sampling density of every band. Looking down at the sine of the angle below the horizon, averaged over the band.
+    for (size_t b = 0; b < m_bands.size(); ++b)
+    {
+        float downward = 0;
+        for (const Samples::Vector& ray : m_bands[b].Rays)
+        {
+            downward += std::max(-ray.Dot(up), 0.0f);
+        }
+        m_downward[b] = m_bands[b].Rays.empty() ? 0.0f : downward / m_bands[b].Rays.size();
+
+        float weight = 1;
+        if (m_options.Strategy == PointSamplingStrategy::FloorBiasedBudget && !m_bands[b].Rays.empty())
+        {
+            weight = m_options.AboveHorizonWeight + (1 - m_options.AboveHorizonWeight) * m_downward[b];
+        }
+        m_weights[b] = m_bands[b].ValidPixelCount > 0 ? weight : 0.0f;
+        m_shares[b] = -1;
+    }
+
+    // The budget is shared in proportion to the density times the size of the bands. A band cannot get more than all
+    // of its pixels, what it cannot use goes to the other bands.
+    double remainingBudget = static_cast<double>(m_pointBudget);
+    bool isSaturated = true;
+    while (isSaturated)
+    {
+        isSaturated = false;
+        double demand = 0;
+        for (size_t b = 0; b < m_bands.size(); ++b)
+        {
+            if (m_shares[b] < 0)
+            {
+                demand += m_weights[b] * m_bands[b].ValidPixelCount;
+            }
+        }
+        if (demand <= 0)
+        {
+            break;
+        }
+
+        for (size_t b = 0; b < m_bands.size(); ++b)
+        {
+            if (m_shares[b] < 0 && remainingBudget * m_weights[b] * m_bands[b].ValidPixelCount / demand >= m_bands[b].ValidPixelCount)
+            {
+                m_shares[b] = static_cast<double>(m_bands[b].ValidPixelCount);
+                remainingBudget -= m_shares[b];
+                isSaturated = true;
+            }
+        }
+
+        if (!isSaturated)
+        {
+            for (size_t b = 0; b < m_bands.size(); ++b)
+            {
+                if (m_shares[b] < 0)
+                {
+                    m_shares[b] = remainingBudget * m_weights[b] * m_bands[b].ValidPixelCount / demand;
+                }
+            }
+        }
+    }
+
+    // Steps of every band, as square as possible and rounded up, so the budget is not exceeded.
+    double sampledPixelCount = 0;
+    double floorSampledRatio = 0;
+    for (size_t b = 0; b < m_bands.size(); ++b)
+    {
+        const RowBand& band = m_bands[b];
+        if (m_shares[b] < 1)
+        {
+            continue;
+        }
+
+        const double ratio = band.ValidPixelCount / m_shares[b];
+        PointCloudRegion region;
+        region.Y = band.Y;
+        region.Height = band.Height;
+        region.StepY = std::min(std::max(static_cast<int>(std::sqrt(ratio)), 1), band.Height);
+        region.StepX = std::min(std::max(static_cast<int>(std::ceil(ratio / region.StepY)), 1), m_width);
+        m_regions.push_back(region);
+
+        sampledPixelCount += static_cast<double>(band.ValidPixelCount) / (region.StepX * region.StepY);
+
+        // Some pixels of the band look below the horizon.
+        if (m_downward[b] > 0)
+        {
+            floorSampledRatio = std::max(floorSampledRatio, 1.0 / (region.StepX * region.StepY));
+        }
+    }
+
+    m_sampledRatio = m_validPixelCount > 0 ? static_cast<float>(sampledPixelCount / m_validPixelCount) : 0.0f;
+
+    // Without any band below the horizon, e.g. a camera looking up, the floor cannot be seen anyway.
+    m_floorSampledRatio = floorSampledRatio > 0 ? static_cast<float>(floorSampledRatio) : m_sampledRatio;
+    return m_regions;
+}
+
+void Samples::PointSampler::UpdateBudget(bool isFloorTracked)
+{
+    if (isFloorTracked)
+    {
+        const size_t shrunkBudget = static_cast<size_t>(m_pointBudget * m_options.BudgetShrinkFactor);
+        m_pointBudget = std::max(std::min(m_options.MinimumPointBudget, m_options.PointBudget), shrunkBudget);
+    }
+    else
+    {
+        m_pointBudget = m_options.PointBudget;
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <k4a/k4atypes.h>
+
+#include "PointCloudBuffer.h"
+#include "SampleMathTypes.h"
+
+#include <vector>
+
+namespace Samples
+{
+    enum class PointSamplingStrategy
+    {
+        // Every DownsampleStep-th pixel of every DownsampleStep-th row. The cost grows with the resolution of the depth
+        // mode.
+        FixedStep,
+
+        // About PointBudget pixels, spread evenly over the image, whatever the depth mode.
+        UniformBudget,
+
+        // About PointBudget pixels, spread over bands of rows in proportion to how far below the horizon they look.
+        // The floor can only be seen below the horizon, and it is closer and less noisy the steeper the pixels look
+        // down, so a floor in a thin band at the bottom of the image gets most of the points.
+        FloorBiasedBudget,
+    };
+
+    struct PointSamplingOptions
+    {
+        PointSamplingStrategy Strategy = PointSamplingStrategy::FloorBiasedBudget;
+        int DownsampleStep = 2;
+        size_t PointBudget = 40000;
+
+        // Adaptive budget, see PointSampler::UpdateBudget(): while the floor is tracked, the budget shrinks by
+        // BudgetShrinkFactor every frame down to MinimumPointBudget. A MinimumPointBudget of PointBudget keeps the
+        // budget fixed.
+        size_t MinimumPointBudget = 10000;
+        float BudgetShrinkFactor = 0.8f;
+
+        // Sampling density of the rows above the horizon relative to the rows looking straight down, so the cloud
+        // still covers the whole image for other uses than the floor.
+        float AboveHorizonWeight = 0.05f;
+    };
+
+    // Sampling strategy of the point cloud used for the floor detection. Turns a point budget into regions of the
+    // depth image with their own sampling steps, for PointCloudGenerator::GetCloudPoints(up, regions), so the cost of
+    // the floor detection per frame is bounded in every depth mode.
+    class PointSampler
+    {
+    public:
+        PointSampler(const k4a_calibration_t& sensorCalibration, const PointSamplingOptions& options = {});
+
+        // Regions to sample for the gravity-aligned up vector, in depth camera coordinates.
+        const std::vector<PointCloudRegion>& GetRegions(const Samples::Vector& up);
+
+        // Shrinks the budget while the floor is tracked, e.g. FloorDetector::IsTracking() after TrackFloorPlane(), and
+        // restores the full budget as soon as it is not, so the full floor search of the next frames has all the points.
+        void UpdateBudget(bool isFloorTracked);
+
+        size_t GetPointBudget() const { return m_pointBudget; }
+
+        // Fraction of the valid pixels of the image sampled by the regions of the last GetRegions().
+        float GetSampledRatio() const { return m_sampledRatio; }
+
+        // Fraction of the pixels sampled in the densest band of rows looking below the horizon, where the floor can be,
+        // to scale the minimum number of floor points. A floor patch anywhere in the image then needs at least as many
+        // pixels as on the full image, while GetSampledRatio() would let small patches of the densely sampled bottom
+        // rows pass with FloorBiasedBudget.
+        float GetFloorSampledRatio() const { return m_floorSampledRatio; }
+
+    private:
+        // Band of image rows, with the unit rays of a coarse grid of its valid pixels.
+        struct RowBand
+        {
+            int Y = 0;
+            int Height = 0;
+            size_t ValidPixelCount = 0;
+            std::vector<Samples::Vector> Rays;
+        };
+
+        const PointSamplingOptions m_options;
+        int m_width = 0;
+        size_t m_validPixelCount = 0;
+        std::vector<RowBand> m_bands;
+        size_t m_pointBudget = 0;
+        float m_sampledRatio = 1;
+        float m_floorSampledRatio = 1;
+        std::vector<PointCloudRegion> m_regions;
+
+        // Scratch space of GetRegions(), one entry per band.
+        std::vector<float> m_downward;
+        std::vector<float> m_weights;
+        std::vector<double> m_shares;
+    };
+}
@@ -0,0 +1,267 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "SyntheticScene.h"
+#include "Utilities.h"
+
+#include <algorithm>    // std::fill, std::min, std::max, std::swap
+#include <cmath>
+
+const float DegreesToRadians = 3.14159265f / 180.0f;
+
+// Standard gravity in meters per second squared.
+const float GravityInMetersPerSecondSquared = 9.81f;
+
+const float TableHeight = 0.75f;
+const float TableTopThickness = 0.04f;
+const float TableLength = 1.2f;
+const float TableWidth = 0.6f;
+const float MinimumClutterSize = 0.1f;
+const float MaximumClutterSize = 0.5f;
+
+// Depth of the room when it has no wall, for the placement of the boxes.
+const float OpenRoomDepth = 3.5f;
+
+Samples::Vector Rotate(const float* rotation, const Samples::Vector& v)
+{
+    return {
+        rotation[0] * v.X + rotation[1] * v.Y + rotation[2] * v.Z,
+        rotation[3] * v.X + rotation[4] * v.Y + rotation[5] * v.Z,
+        rotation[6] * v.X + rotation[7] * v.Y + rotation[8] * v.Z };
+}
+
+void Transpose(const float* rotation, float* transposed)
+{
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int column = 0; column < 3; ++column)
+        {
+            transposed[column * 3 + row] = rotation[row * 3 + column];
+        }
+    }
+}
+
+k4a_calibration_t Samples::CreateSyntheticCalibration(k4a_depth_mode_t depthMode)
+{
+    int width = 640;
+    int height = 576;
+    float focalLength = 504.0f;
+    switch (depthMode)
+    {
+    case K4A_DEPTH_MODE_NFOV_2X2BINNED:
+        width = 320;
+        height = 288;
+        focalLength = 252.0f;
+        break;
+    case K4A_DEPTH_MODE_WFOV_2X2BINNED:
+        width = 512;
+        height = 512;
+        focalLength = 252.0f;
+        break;
+    case K4A_DEPTH_MODE_WFOV_UNBINNED:
+        width = 1024;
+        height = 1024;
+        break;
+    default:
+        break;
+    }
+
+    k4a_calibration_t calibration = {};
+    calibration.depth_mode = depthMode;
+    calibration.color_resolution = K4A_COLOR_RESOLUTION_OFF;
+
+    k4a_calibration_camera_t& depthCamera = calibration.depth_camera_calibration;
+    depthCamera.resolution_width = width;
+    depthCamera.resolution_height = height;
+    depthCamera.metric_radius = 1.7f;
+    depthCamera.intrinsics.type = K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY;
+    depthCamera.intrinsics.parameter_count = 14;
+    depthCamera.intrinsics.parameters.param.cx = width / 2.0f;
+    depthCamera.intrinsics.parameters.param.cy = height / 2.0f;
+    depthCamera.intrinsics.parameters.param.fx = focalLength;
+    depthCamera.intrinsics.parameters.param.fy = focalLength;
+
+    for (int i = 0; i < K4A_CALIBRATION_TYPE_NUM; ++i)
+    {
+        for (int j = 0; j < K4A_CALIBRATION_TYPE_NUM; ++j)
+        {
+            k4a_calibration_extrinsics_t& extrinsics = calibration.extrinsics[i][j];
+            std::fill(std::begin(extrinsics.rotation), std::end(extrinsics.rotation), 0.0f);
+            std::fill(std::begin(extrinsics.translation), std::end(extrinsics.translation), 0.0f);
+            extrinsics.rotation[0] = extrinsics.rotation[4] = extrinsics.rotation[8] = 1.0f;
+        }
+    }
+    return calibration;
+}
+
+Samples::SyntheticScene::SyntheticScene(const k4a_calibration_t& sensorCalibration, const SyntheticSceneOptions& options)
+    : m_options(options)
+    , m_width(sensorCalibration.depth_camera_calibration.resolution_width)
+    , m_height(sensorCalibration.depth_camera_calibration.resolution_height)
+    , m_random(options.Seed)
+{
+    m_rays.reserve(static_cast<size_t>(m_width) * m_height);
+    for (int h = 0; h < m_height; h++)
+    {
+        for (int w = 0; w < m_width; w++)
+        {
+            k4a_float2_t pixel = { { static_cast<float>(w), static_cast<float>(h) } };
+            k4a_float3_t ray;
+            int valid = 0;
+            VERIFY(k4a_calibration_2d_to_3d(&sensorCalibration,
+                &pixel,
+                1.f,
+                K4A_CALIBRATION_TYPE_DEPTH,
+                K4A_CALIBRATION_TYPE_DEPTH,
+                &ray,
+                &valid), "Unproject depth pixel failed!");
+            m_rays.push_back(valid != 0 ? Samples::Vector(ray) : Samples::Vector(0, 0, 0));
+        }
+    }
+
+    // A level camera looks along z with up along -y. Pitching it down tilts up towards -z, the roll turns it around z.
+    const float pitch = options.CameraPitch * DegreesToRadians;
+    const float roll = options.CameraRoll * DegreesToRadians;
+    m_up = Samples::Vector(std::cos(pitch) * std::sin(roll), -std::cos(pitch) * std::cos(roll), -std::sin(pitch));
+    m_forward = (Samples::Vector(0, 0, 1) - m_up * m_up.Dot(Samples::Vector(0, 0, 1))).Normalized();
+    m_right = m_forward * m_up;
+
+    // The floor goes through the point below the camera.
+    const float tilt = options.FloorTilt * DegreesToRadians;
+    m_floorNormal = m_up * std::cos(tilt) + m_forward * std::sin(tilt);
+    m_floorPlane = Samples::Plane::Create(m_floorNormal, m_up * -options.CameraHeight);
+
+    // Tables and clutter in front of the camera, within the room.
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    auto random = [&](float minimum, float maximum) { return minimum + (maximum - minimum) * uniform(m_random); };
+    const float roomDepth = options.WallDistance > 0 ? options.WallDistance : OpenRoomDepth;
+
+    for (int i = 0; i < options.TableCount; ++i)
+    {
+        float length = TableLength;
+        float width = TableWidth;
+        if (uniform(m_random) < 0.5f)
+        {
+            std::swap(length, width);
+        }
+        float right = random(-1.0f, 1.0f);
+        float forward = random(1.0f, std::max(1.0f, roomDepth - width));
+        m_boxes.push_back({ { right - length / 2, forward - width / 2, TableHeight - TableTopThickness },
+            { right + length / 2, forward + width / 2, TableHeight } });
+    }
+
+    for (int i = 0; i < options.ClutterCount; ++i)
+    {
+        float size[3];
+        for (float& s : size)
+        {
+            s = random(MinimumClutterSize, MaximumClutterSize);
+        }
+        float right = random(-1.5f, 1.5f);
+        float forward = random(0.8f, std::max(0.8f, roomDepth - size[1]));
+        m_boxes.push_back({ { right - size[0] / 2, forward - size[1] / 2, 0.0f },
+            { right + size[0] / 2, forward + size[1] / 2, size[2] } });
+    }
+
+    const auto& accelerometerToDepth = sensorCalibration.extrinsics[K4A_CALIBRATION_TYPE_ACCEL][K4A_CALIBRATION_TYPE_DEPTH].rotation;
+    const auto& gyroscopeToDepth = sensorCalibration.extrinsics[K4A_CALIBRATION_TYPE_GYRO][K4A_CALIBRATION_TYPE_DEPTH].rotation;
+    Transpose(accelerometerToDepth, m_depthToAccelerometer);
+    Transpose(gyroscopeToDepth, m_depthToGyroscope);
+}
+
+float Samples::SyntheticScene::CastRay(const Samples::Vector& ray) const
+{
+    float distance = 0;
+    auto hit = [&distance](float t) {
+        if (t > 0 && (distance == 0 || t < distance))
+        {
+            distance = t;
+        }
+    };
+
+    // Floor: floorNormal.Dot(point) = floorNormal.Dot(below camera).
+    const float floorDot = m_floorNormal.Dot(ray);
+    if (floorDot < 0)
+    {
+        hit(m_floorPlane.C / -floorDot);
+    }
+
+    // Wall: forward.Dot(point) = WallDistance.
+    const float forwardDot = m_forward.Dot(ray);
+    if (m_options.WallDistance > 0 && forwardDot > 0)
+    {
+        hit(m_options.WallDistance / forwardDot);
+    }
+
+    // Boxes, with the slab test in room coordinates, where the camera is at (0, 0, CameraHeight).
+    const float origin[3] = { 0, 0, m_options.CameraHeight };
+    const float direction[3] = { m_right.Dot(ray), forwardDot, m_up.Dot(ray) };
+    for (const Box& box : m_boxes)
+    {
+        float enter = 0;
+        float exit = INFINITY;
+        for (int axis = 0; axis < 3 && enter <= exit; ++axis)
+        {
+            if (direction[axis] == 0)
+            {
+                if (origin[axis] < box.Min[axis] || origin[axis] > box.Max[axis])
+                {
+                    exit = -1;
+                }
+                continue;
+            }
+
+            float t1 = (box.Min[axis] - origin[axis]) / direction[axis];
+            float t2 = (box.Max[axis] - origin[axis]) / direction[axis];
+            enter = std::max(enter, std::min(t1, t2));
+            exit = std::min(exit, std::max(t1, t2));
+        }
+        if (enter <= exit)
+        {
+            hit(enter);
+        }
+    }
+    return distance;
+}
+
+void Samples::SyntheticScene::RenderDepthImage(k4a_image_t depthImage)
+{
+    EXIT_IF(k4a_image_get_width_pixels(depthImage) != m_width || k4a_image_get_height_pixels(depthImage) != m_height,
+        "Depth image does not match the calibration!");
+
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, m_options.DepthNoiseInMillimeters);
+
+    uint16_t* depth = reinterpret_cast<uint16_t*>(k4a_image_get_buffer(depthImage));
+    for (size_t i = 0; i < m_rays.size(); ++i)
+    {
+        // The rays have z = 1, so the distance along a ray is the depth of its pixel.
+        float z = m_rays[i].Z > 0 ? CastRay(m_rays[i]) : 0.0f;
+        bool valid = z >= m_options.MinimumDepth && z <= m_options.MaximumDepth && uniform(m_random) >= m_options.MissingPixelRatio;
+
+        float depthInMillimeters = valid ? z * 1000.0f + noise(m_random) * z : 0.0f;
+        depth[i] = static_cast<uint16_t>(std::min(std::max(depthInMillimeters + 0.5f, 0.0f), 65535.0f));
+    }
+}
+
+k4a_imu_sample_t Samples::SyntheticScene::CreateImuSample(uint64_t timestampUsec)
+{
+    std::normal_distribution<float> accelerometerNoise(0.0f, m_options.AccelerometerNoise);
+    std::normal_distribution<float> gyroscopeNoise(0.0f, m_options.GyroscopeNoise);
+
+    // An accelerometer at rest measures an acceleration straight upwards.
+    Samples::Vector acceleration = m_up * GravityInMetersPerSecondSquared +
+        Samples::Vector(accelerometerNoise(m_random), accelerometerNoise(m_random), accelerometerNoise(m_random));
+    Samples::Vector angularVelocity(gyroscopeNoise(m_random), gyroscopeNoise(m_random), gyroscopeNoise(m_random));
+
+    Samples::Vector accelerometerSample = Rotate(m_depthToAccelerometer, acceleration);
+    Samples::Vector gyroscopeSample = Rotate(m_depthToGyroscope, angularVelocity);
+
+    k4a_imu_sample_t imuSample = {};
+    imuSample.temperature = 30.0f;
+    imuSample.acc_sample = { { accelerometerSample.X, accelerometerSample.Y, accelerometerSample.Z } };
+    imuSample.acc_timestamp_usec = timestampUsec;
+    imuSample.gyro_sample = { { gyroscopeSample.X, gyroscopeSample.Y, gyroscopeSample.Z } };
+    imuSample.gyro_timestamp_usec = timestampUsec;
+    return imuSample;
+}
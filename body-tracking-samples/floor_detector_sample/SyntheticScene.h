@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <k4a/k4a.h>
+
+#include "SampleMathTypes.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace Samples
+{
+    // Depth camera calibration of an ideal pinhole camera without lens distortion, with the resolution and about the
+    // focal length of depthMode. All the sensors of the device are at the same place.
+    k4a_calibration_t CreateSyntheticCalibration(k4a_depth_mode_t depthMode);
+
+    // Room seen by a device at rest, see SyntheticScene. Distances are in meters, angles in degrees.
+    struct SyntheticSceneOptions
+    {
+        // Pose of the camera above the floor. A positive pitch looks down, the roll turns the camera around its
+        // optical axis.
+        float CameraHeight = 1.5f;
+        float CameraPitch = 30.0f;
+        float CameraRoll = 0.0f;
+
+        // Angle between the floor and the horizontal, e.g. a ramp, sloping down away from the camera.
+        float FloorTilt = 0.0f;
+
+        // Distance of a wall in front of the camera, 0 for no wall.
+        float WallDistance = 3.0f;
+
+        // Number of tables, 0.75m high with a 1.2m x 0.6m top, and of boxes of 0.1m to 0.5m on the floor, at random
+        // places in front of the camera.
+        int TableCount = 0;
+        int ClutterCount = 0;
+
+        // Standard deviation of the depth noise at 1m, it grows linearly with the distance, and fraction of the pixels
+        // that have no depth. Pixels outside of [MinimumDepth, MaximumDepth] have no depth either.
+        float DepthNoiseInMillimeters = 2.0f;
+        float MissingPixelRatio = 0.05f;
+        float MinimumDepth = 0.25f;
+        float MaximumDepth = 5.0f;
+
+        // Standard deviation of the IMU noise, in meters per second squared and radians per second.
+        float AccelerometerNoise = 0.02f;
+        float GyroscopeNoise = 0.002f;
+
+        uint32_t Seed = 42;
+    };
+
+    // Renders depth images and IMU samples of a room for the calibration of a real or synthetic device, so the floor
+    // detection can be measured without a device. The room is made of a floor, an optional wall and boxes standing on
+    // the floor, it is laid out once from the seed. Every frame has new depth noise, missing pixels and IMU noise.
+    class SyntheticScene
+    {
+    public:
+        SyntheticScene(const k4a_calibration_t& sensorCalibration, const SyntheticSceneOptions& options);
+
+        // Gravity-aligned up vector in depth camera coordinates.
+        const Samples::Vector& GetUp() const { return m_up; }
+
+        // True floor plane in depth camera coordinates, in meters, with its normal pointing up.
+        const Samples::Plane& GetFloorPlane() const { return m_floorPlane; }
+
+        // Fills depthImage, a DEPTH16 image of the calibration's resolution, with the next frame.
+        void RenderDepthImage(k4a_image_t depthImage);
+
+        // IMU sample of the device at rest at timestampUsec, in the coordinates of the IMU sensors.
+        k4a_imu_sample_t CreateImuSample(uint64_t timestampUsec);
+
+    private:
+        // Axis-aligned box in room coordinates: right, forward and elevation above the floor below the camera.
+        struct Box
+        {
+            float Min[3];
+            float Max[3];
+        };
+
+        // Distance along a camera ray (with z = 1) to the nearest surface of the room, 0 if there is none.
+        float CastRay(const Samples::Vector& ray) const;
+
+        const SyntheticSceneOptions m_options;
+        int m_width = 0;
+        int m_height = 0;
+
+        // Ray of every depth pixel with z = 1, or 0 for the pixels without a valid unprojection.
+        std::vector<Samples::Vector> m_rays;
+
+        Samples::Vector m_up = { 0, -1, 0 };
+        Samples::Vector m_forward = { 0, 0, 1 };
+        Samples::Vector m_right = { 1, 0, 0 };
+        Samples::Vector m_floorNormal = { 0, -1, 0 };
+        Samples::Plane m_floorPlane = Samples::Plane::Create(Samples::Vector(0, -1, 0), Samples::Vector(0, 0, 0));
+        std::vector<Box> m_boxes;
+
+        // Row-major rotations from the depth camera to the IMU sensors.
+        float m_depthToAccelerometer[9];
+        float m_depthToGyroscope[9];
+
+        std::mt19937 m_random;
+    };
+}
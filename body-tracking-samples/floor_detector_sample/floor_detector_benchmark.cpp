@@ -0,0 +1,286 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <k4a/k4a.h>
+
+#include "FloorDetector.h"
+#include "PointCloudGenerator.h"
+#include "SyntheticScene.h"
+#include "Utilities.h"
+
+// Compares the table driven point cloud conversion of PointCloudGenerator against the SDK point cloud image, with and
+// without threads, the single pass conversion against the conversion followed by the elevation computation of
+// FloorDetector, the structure of arrays output against the vector of points, and the full floor search against the
+// threaded search, temporal floor tracking and the search of all horizontal planes.
+// Runs on a synthetic depth frame, no device is needed.
+
+// Point cloud conversion of the SDK: an int16 point cloud image in millimeters, converted to float points in meters.
+void ConvertWithSdk(k4a_transformation_t transformation, k4a_image_t depthImage, k4a_image_t pointCloudImage, int step, std::vector<k4a_float3_t>& points)
+{
+    VERIFY(k4a_transformation_depth_image_to_point_cloud(transformation, depthImage, K4A_CALIBRATION_TYPE_DEPTH, pointCloudImage),
+        "Transform depth image to point clouds failed!");
+
+    const int width = k4a_image_get_width_pixels(pointCloudImage);
+    const int height = k4a_image_get_height_pixels(pointCloudImage);
+    const int16_t* pointCloud = reinterpret_cast<const int16_t*>(k4a_image_get_buffer(pointCloudImage));
+
+    points.clear();
+    for (int h = 0; h < height; h += step)
+    {
+        for (int w = 0; w < width; w += step)
+        {
+            const int16_t* xyz = pointCloud + 3 * (h * width + w);
+            if (xyz[2] > 0)
+            {
+                points.push_back({ { xyz[0] * 0.001f, xyz[1] * 0.001f, xyz[2] * 0.001f } });
+            }
+        }
+    }
+}
+
+template <typename Function>
+double MeasureMicroseconds(int iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        function();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+}
+
+void RunBenchmark(const char* modeName, k4a_depth_mode_t depthMode, int iterations)
+{
+    // Camera 1.5m above the floor and 3m away from a wall, pitched down by 30 degrees.
+    k4a_calibration_t calibration = Samples::CreateSyntheticCalibration(depthMode);
+    Samples::SyntheticScene scene{ calibration, {} };
+    const Samples::Vector& up = scene.GetUp();
+
+    const int width = calibration.depth_camera_calibration.resolution_width;
+    const int height = calibration.depth_camera_calibration.resolution_height;
+    k4a_image_t depthImage = nullptr;
+    VERIFY(k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, width, height, width * (int)sizeof(uint16_t), &depthImage),
+        "Create depth image failed!");
+    scene.RenderDepthImage(depthImage);
+
+    Samples::PointCloudGenerator pointCloudGenerator{ calibration };
+    pointCloudGenerator.Update(depthImage);
+
+    k4a_transformation_t transformation = k4a_transformation_create(&calibration);
+    k4a_image_t pointCloudImage = nullptr;
+    VERIFY(k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM, width, height, width * 3 * (int)sizeof(int16_t), &pointCloudImage),
+        "Create Point Cloud Image failed!");
+
+    Samples::ThreadPool threadPool;
+    for (int step : { 1, 2, 4 })
+    {
+        // The SDK rounds the points to whole millimeters, the table driven conversion does not.
+        std::vector<k4a_float3_t> sdkPoints;
+        double sdkTime = MeasureMicroseconds(iterations, [&]() { ConvertWithSdk(transformation, depthImage, pointCloudImage, step, sdkPoints); });
+        printf("%-6s %4dx%-4d step %d  %8zu points  %-14s %9.1f us\n", modeName, width, height, step,
+            sdkPoints.size(), "sdk", sdkTime);
+
+        for (Samples::ThreadPool* pool : { (Samples::ThreadPool*)nullptr, &threadPool })
+        {
+            for (Samples::SimdLevel level : { Samples::SimdLevel::Scalar, Samples::SimdLevel::Sse41, Samples::SimdLevel::Avx2 })
+            {
+                if (level > Samples::GetSupportedSimdLevel())
+                {
+                    continue;
+                }
+
+                // Every image goes through the pool, to measure it on the sampled images too.
+                pointCloudGenerator.SetSimdLevel(level);
+                pointCloudGenerator.SetThreadPool(pool, 0);
+                double time = MeasureMicroseconds(iterations, [&]() { pointCloudGenerator.GetCloudPoints(step); });
+
+                const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(step);
+                float maxDifference = cloudPoints.size() == sdkPoints.size() ? 0.0f : INFINITY;
+                for (size_t i = 0; i < cloudPoints.size() && i < sdkPoints.size(); ++i)
+                {
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        maxDifference = std::max(maxDifference, std::abs(cloudPoints[i].v[j] - sdkPoints[i].v[j]));
+                    }
+                }
+
+                char name[64];
+                snprintf(name, sizeof(name), "table %s%s", Samples::GetSimdLevelName(level), pool != nullptr ? " threads" : "");
+                printf("%-6s %4dx%-4d step %d  %8zu points  %-14s %9.1f us  %5.2fx  max difference %.2f mm %s\n", modeName, width, height, step,
+                    cloudPoints.size(), name, time, sdkTime / time, maxDifference * 1000.0f, maxDifference <= 0.0006f ? "ok" : "MISMATCH");
+            }
+        }
+        pointCloudGenerator.SetThreadPool(nullptr);
+
+        // Original path: float conversion, then one dot product per point.
+        std::vector<float> referenceElevations;
+        double referenceTime = MeasureMicroseconds(iterations, [&]() {
+            const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(step);
+            referenceElevations.resize(cloudPoints.size());
+            for (size_t i = 0; i < cloudPoints.size(); ++i)
+            {
+                referenceElevations[i] = up.Dot(Samples::Vector(cloudPoints[i]));
+            }
+        });
+        const std::vector<k4a_float3_t> referencePoints = pointCloudGenerator.GetCloudPoints(step);
+
+        printf("%-6s %4dx%-4d step %d  %8zu points  %-14s %9.1f us\n", modeName, width, height, step,
+            referencePoints.size(), "two pass", referenceTime);
+
+        for (Samples::SimdLevel level : { Samples::SimdLevel::Scalar, Samples::SimdLevel::Sse41, Samples::SimdLevel::Avx2 })
+        {
+            if (level > Samples::GetSupportedSimdLevel())
+            {
+                continue;
+            }
+
+            pointCloudGenerator.SetSimdLevel(level);
+            double time = MeasureMicroseconds(iterations, [&]() { pointCloudGenerator.GetCloudPoints(up, step); });
+
+            // The single pass must produce exactly the same points and elevations.
+            const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(up, step);
+            const auto& elevations = pointCloudGenerator.GetElevations();
+            bool identical = cloudPoints.size() == referencePoints.size() &&
+                std::equal(elevations.begin(), elevations.end(), referenceElevations.begin()) &&
+                std::equal(cloudPoints.begin(), cloudPoints.end(), referencePoints.begin(), [](const k4a_float3_t& a, const k4a_float3_t& b) {
+                    return a.xyz.x == b.xyz.x && a.xyz.y == b.xyz.y && a.xyz.z == b.xyz.z;
+                });
+
+            printf("%-6s %4dx%-4d step %d  %8zu points  single pass %-6s %6.1f us  %5.2fx  %s\n", modeName, width, height, step,
+                cloudPoints.size(), Samples::GetSimdLevelName(level), time, referenceTime / time, identical ? "identical" : "MISMATCH");
+        }
+
+        // Structure of arrays output, with the pixel index of every point, to a buffer that is allocated once.
+        // Compared against the vector of points without elevations.
+        Samples::PointCloudRegion region;
+        region.StepX = step;
+        region.StepY = step;
+        Samples::AlignedPointCloudBuffer buffer(pointCloudGenerator.GetMaxPointCount(region), true);
+        const Samples::PointCloudArrays& arrays = buffer.GetArrays();
+
+        double vectorTime = MeasureMicroseconds(iterations, [&]() { pointCloudGenerator.GetCloudPoints(step); });
+        printf("%-6s %4dx%-4d step %d  %8zu points  %-14s %9.1f us\n", modeName, width, height, step,
+            referencePoints.size(), "vector", vectorTime);
+
+        std::vector<uint32_t> referencePixelIndices;
+        for (Samples::SimdLevel level : { Samples::SimdLevel::Scalar, Samples::SimdLevel::Sse41, Samples::SimdLevel::Avx2 })
+        {
+            if (level > Samples::GetSupportedSimdLevel())
+            {
+                continue;
+            }
+
+            pointCloudGenerator.SetSimdLevel(level);
+            double time = MeasureMicroseconds(iterations, [&]() { pointCloudGenerator.GetCloudPoints(region, arrays); });
+
+            // Same points as the vector, and the same pixel indices as the scalar kernel, which are on the step grid.
+            size_t pointCount = pointCloudGenerator.GetCloudPoints(region, arrays);
+            bool identical = pointCount == referencePoints.size();
+            for (size_t i = 0; i < pointCount && identical; ++i)
+            {
+                uint32_t pixelIndex = arrays.PixelIndices[i];
+                identical = arrays.X[i] == referencePoints[i].xyz.x && arrays.Y[i] == referencePoints[i].xyz.y &&
+                    arrays.Z[i] == referencePoints[i].xyz.z && (pixelIndex / width) % step == 0 && (pixelIndex % width) % step == 0 &&
+                    (referencePixelIndices.empty() || referencePixelIndices[i] == pixelIndex);
+            }
+            if (referencePixelIndices.empty())
+            {
+                referencePixelIndices.assign(arrays.PixelIndices, arrays.PixelIndices + pointCount);
+            }
+
+            printf("%-6s %4dx%-4d step %d  %8zu points  arrays %-11s %6.1f us  %5.2fx  %s\n", modeName, width, height, step,
+                pointCount, Samples::GetSimdLevelName(level), time, vectorTime / time, identical ? "identical" : "MISMATCH");
+        }
+    }
+
+    // Floor detection on the cloud used by the sample, and on the full resolution cloud with and without threads.
+    // Tracking starts with one full search, the measured frames then only verify the tracked floor.
+    for (int step : { 2, 1 })
+    {
+        const size_t minimumFloorPointCount = 1024 / (step * step);
+        const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(up, step);
+        const auto& elevations = pointCloudGenerator.GetElevations();
+
+        auto printPlane = [&](const char* name, const std::optional<Samples::Plane>& plane, double time) {
+            printf("%-6s %4dx%-4d step %d  %-26s %9.1f us  ", modeName, width, height, step, name, time);
+            if (plane.has_value())
+            {
+                printf("floor elevation %.6f m\n", -plane->C);
+            }
+            else
+            {
+                printf("no floor\n");
+            }
+        };
+
+        Samples::FloorDetector searchDetector;
+        std::optional<Samples::Plane> detectedPlane;
+        double detectionTime = MeasureMicroseconds(iterations, [&]() {
+            detectedPlane = searchDetector.TryDetectFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount);
+        });
+        printPlane("floor full search", detectedPlane, detectionTime);
+
+        // Every point count goes through the pool, to measure it on the small clouds too.
+        Samples::ParallelOptions parallelOptions;
+        parallelOptions.Pool = &threadPool;
+        parallelOptions.MinimumPointCount = 0;
+        std::optional<Samples::Plane> parallelPlane;
+        double parallelTime = MeasureMicroseconds(iterations, [&]() {
+            parallelPlane = searchDetector.TryDetectFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions);
+        });
+
+        // The partial histograms are added in a fixed order, so every run gives the same plane.
+        auto repeatedPlane = searchDetector.TryDetectFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions);
+        bool reproducible = parallelPlane.has_value() == repeatedPlane.has_value() &&
+            (!parallelPlane.has_value() || (parallelPlane->C == repeatedPlane->C &&
+                parallelPlane->Origin.X == repeatedPlane->Origin.X &&
+                parallelPlane->Origin.Y == repeatedPlane->Origin.Y &&
+                parallelPlane->Origin.Z == repeatedPlane->Origin.Z));
+
+        char parallelName[64];
+        snprintf(parallelName, sizeof(parallelName), "floor full search %zu threads", threadPool.GetThreadCount());
+        printPlane(parallelName, parallelPlane, parallelTime);
+        printf("%-6s %4dx%-4d step %d  %-26s %5.2fx %s\n", modeName, width, height, step, "", detectionTime / parallelTime,
+            reproducible ? "reproducible" : "NOT REPRODUCIBLE");
+
+        Samples::FloorDetector floorDetector;
+        std::optional<Samples::Plane> trackedPlane = floorDetector.TrackFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount);
+        double trackingTime = MeasureMicroseconds(iterations, [&]() {
+            trackedPlane = floorDetector.TrackFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount);
+        });
+        printPlane("floor tracking", trackedPlane, trackingTime);
+
+        std::vector<Samples::HorizontalPlane> horizontalPlanes;
+        double horizontalPlanesTime = MeasureMicroseconds(iterations, [&]() {
+            horizontalPlanes = searchDetector.DetectHorizontalPlanes(cloudPoints, elevations, up, minimumFloorPointCount);
+        });
+        printf("%-6s %4dx%-4d step %d  %-26s %9.1f us  %zu planes\n", modeName, width, height, step, "horizontal planes",
+            horizontalPlanesTime, horizontalPlanes.size());
+        for (const auto& plane : horizontalPlanes)
+        {
+            printf("%-6s %4dx%-4d step %d  %-26s elevation %.3f m  %zu points  %.2f m x %.2f m\n", modeName, width, height, step, "",
+                plane.Elevation, plane.InlierCount, plane.MajorLength, plane.MinorLength);
+        }
+    }
+
+    k4a_image_release(pointCloudImage);
+    k4a_transformation_destroy(transformation);
+    k4a_image_release(depthImage);
+}
+
+int main()
+{
+    const int iterations = 100;
+    printf("Best supported instruction set: %s\n", Samples::GetSimdLevelName(Samples::GetSupportedSimdLevel()));
+
+    RunBenchmark("NFOV", K4A_DEPTH_MODE_NFOV_UNBINNED, iterations);
+    RunBenchmark("WFOV", K4A_DEPTH_MODE_WFOV_UNBINNED, iterations);
+    return 0;
+}
@@ -0,0 +1,295 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <k4a/k4a.h>
+
+#include "FloorDetector.h"
+#include "GravityEstimator.h"
+#include "PointCloudGenerator.h"
+#include "PointSampler.h"
+#include "SyntheticScene.h"
+#include "Utilities.h"
+
+// Measures the floor detection pipeline of the sample on synthetic rooms, without a device: for every scene, depth mode
+// and point sampling strategy, frames are rendered with new noise, gravity is estimated by GravityEstimator from a simulated
+// IMU stream, and the point cloud conversion, the full floor search and temporal floor tracking are timed. Reports the
+// latency and throughput, the detection rate and the error of the detected floor against the true floor.
+//
+// Usage: floor_detector_scene_benchmark [raw calibration file]
+// With a raw calibration, e.g. saved from k4a_device_get_raw_calibration(), the scenes are rendered with the lens of
+// that device instead of an ideal pinhole camera.
+
+const int FrameCount = 20;
+
+// The IMU of the device runs at 1.6kHz, the depth camera at 30 frames per second.
+const uint64_t ImuSampleIntervalUsec = 625;
+const uint64_t FrameIntervalUsec = 33333;
+
+// A detected floor farther than this from the true floor is counted as wrong.
+const float MaxFloorErrorInMeters = 0.05f;
+
+struct Scene
+{
+    const char* Name;
+    Samples::SyntheticSceneOptions Options;
+};
+
+std::vector<Scene> CreateScenes()
+{
+    std::vector<Scene> scenes;
+    scenes.push_back({ "floor and wall", {} });
+
+    Scene level = { "level camera", {} };
+    level.Options.CameraPitch = 0.0f;
+    scenes.push_back(level);
+
+    Scene roll = { "camera roll 15", {} };
+    roll.Options.CameraRoll = 15.0f;
+    scenes.push_back(roll);
+
+    Scene ramp = { "floor tilt 3", {} };
+    ramp.Options.FloorTilt = 3.0f;
+    scenes.push_back(ramp);
+
+    Scene tables = { "tables", {} };
+    tables.Options.TableCount = 4;
+    scenes.push_back(tables);
+
+    Scene clutter = { "clutter", {} };
+    clutter.Options.ClutterCount = 40;
+    scenes.push_back(clutter);
+
+    Scene noisy = { "noise and holes", {} };
+    noisy.Options.DepthNoiseInMillimeters = 10.0f;
+    noisy.Options.MissingPixelRatio = 0.4f;
+    scenes.push_back(noisy);
+    return scenes;
+}
+
+struct Sampling
+{
+    const char* Name;
+    Samples::PointSamplingOptions Options;
+};
+
+std::vector<Sampling> CreateSamplings()
+{
+    std::vector<Sampling> samplings = { { "step 1", {} }, { "step 2", {} }, { "step 4", {} } };
+    for (size_t i = 0; i < samplings.size(); ++i)
+    {
+        samplings[i].Options.Strategy = Samples::PointSamplingStrategy::FixedStep;
+        samplings[i].Options.DownsampleStep = 1 << i;
+    }
+
+    Sampling uniform = { "uniform 40k", {} };
+    uniform.Options.Strategy = Samples::PointSamplingStrategy::UniformBudget;
+    uniform.Options.MinimumPointBudget = uniform.Options.PointBudget;
+    samplings.push_back(uniform);
+
+    Sampling floorBiased = { "floor 40k", {} };
+    floorBiased.Options.MinimumPointBudget = floorBiased.Options.PointBudget;
+    samplings.push_back(floorBiased);
+
+    // The budget shrinks while the floor is tracked.
+    samplings.push_back({ "adaptive", {} });
+    return samplings;
+}
+
+bool TryLoadCalibration(const std::vector<char>& rawCalibration, k4a_depth_mode_t depthMode, k4a_calibration_t& calibration)
+{
+    return K4A_RESULT_SUCCEEDED == k4a_calibration_get_from_raw(const_cast<char*>(rawCalibration.data()), rawCalibration.size(),
+        depthMode, K4A_COLOR_RESOLUTION_OFF, &calibration);
+}
+
+double Percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+double Mean(const std::vector<double>& values)
+{
+    double sum = 0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    return values.empty() ? 0 : sum / values.size();
+}
+
+// Per frame measurements of one sampling strategy.
+struct SamplingResults
+{
+    std::vector<double> CloudTimes;
+    std::vector<double> DetectionTimes;
+    std::vector<double> TrackingTimes;
+    std::vector<double> TotalTimes;
+    std::vector<double> PointCounts;
+    std::vector<double> FloorErrors;
+    std::vector<double> NormalErrors;
+    int FrameCount = 0;
+    int CorrectCount = 0;
+};
+
+void RunScene(const char* modeName, const k4a_calibration_t& calibration, const Scene& scene, Samples::ThreadPool& threadPool)
+{
+    Samples::SyntheticScene syntheticScene{ calibration, scene.Options };
+    Samples::GravityEstimator gravityEstimator{ calibration };
+    Samples::PointCloudGenerator pointCloudGenerator{ calibration };
+    pointCloudGenerator.SetThreadPool(&threadPool);
+
+    Samples::ParallelOptions parallelOptions;
+    parallelOptions.Pool = &threadPool;
+
+    const int width = calibration.depth_camera_calibration.resolution_width;
+    const int height = calibration.depth_camera_calibration.resolution_height;
+    k4a_image_t depthImage = nullptr;
+    VERIFY(k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, width, height, width * (int)sizeof(uint16_t), &depthImage),
+        "Create depth image failed!");
+
+    const std::vector<Sampling> samplings = CreateSamplings();
+    std::vector<Samples::PointSampler> pointSamplers;
+    for (const Sampling& sampling : samplings)
+    {
+        pointSamplers.emplace_back(calibration, sampling.Options);
+    }
+    std::vector<SamplingResults> results(samplings.size());
+    std::vector<Samples::FloorDetector> floorDetectors(samplings.size());
+    Samples::FloorDetector searchDetector;
+
+    // The true floor point below the camera.
+    const Samples::Vector floorPoint = syntheticScene.GetUp() * -scene.Options.CameraHeight;
+
+    uint64_t timestampUsec = 0;
+    for (int frame = 0; frame < FrameCount; ++frame)
+    {
+        for (uint64_t imuTime = 0; imuTime < FrameIntervalUsec; imuTime += ImuSampleIntervalUsec)
+        {
+            timestampUsec += ImuSampleIntervalUsec;
+            gravityEstimator.AddImuSample(syntheticScene.CreateImuSample(timestampUsec));
+        }
+        syntheticScene.RenderDepthImage(depthImage);
+
+        Samples::GravitySnapshot gravity = gravityEstimator.GetSnapshot();
+        if (!gravity.IsValid)
+        {
+            continue;
+        }
+        Samples::Vector up = gravity.Gravity * -1;
+
+        for (size_t s = 0; s < samplings.size(); ++s)
+        {
+            SamplingResults& result = results[s];
+
+            auto start = std::chrono::steady_clock::now();
+            pointCloudGenerator.Update(depthImage);
+            const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(up, pointSamplers[s].GetRegions(up));
+            const auto& elevations = pointCloudGenerator.GetElevations();
+            const size_t minimumFloorPointCount = static_cast<size_t>(1024 * pointSamplers[s].GetFloorSampledRatio());
+            auto cloudEnd = std::chrono::steady_clock::now();
+            std::optional<Samples::Plane> floorPlane = searchDetector.TryDetectFloorPlane(
+                cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions);
+            auto detectionEnd = std::chrono::steady_clock::now();
+
+            // Tracking is timed on its own, it replaces the full search while the device is at rest.
+            auto trackingStart = std::chrono::steady_clock::now();
+            floorDetectors[s].TrackFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions);
+            auto trackingEnd = std::chrono::steady_clock::now();
+            pointSamplers[s].UpdateBudget(floorDetectors[s].IsTracking());
+
+            auto microseconds = [](auto duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+            result.CloudTimes.push_back(microseconds(cloudEnd - start));
+            result.DetectionTimes.push_back(microseconds(detectionEnd - cloudEnd));
+            result.TrackingTimes.push_back(microseconds(trackingEnd - trackingStart));
+            result.TotalTimes.push_back(microseconds(detectionEnd - start));
+            result.PointCounts.push_back(static_cast<double>(cloudPoints.size()));
+            result.FrameCount++;
+
+            if (floorPlane.has_value())
+            {
+                float floorError = floorPlane->AbsDistance(floorPoint);
+                float normalError = floorPlane->Normal.Angle(syntheticScene.GetFloorPlane().Normal) * 180.0f / 3.14159265f;
+                result.FloorErrors.push_back(floorError * 1000.0);
+                result.NormalErrors.push_back(normalError);
+                result.CorrectCount += floorError <= MaxFloorErrorInMeters;
+            }
+        }
+    }
+
+    for (size_t s = 0; s < samplings.size(); ++s)
+    {
+        const SamplingResults& result = results[s];
+        const double meanTotal = Mean(result.TotalTimes);
+        const double maxFloorError = result.FloorErrors.empty() ? 0 : *std::max_element(result.FloorErrors.begin(), result.FloorErrors.end());
+        printf("%-16s %-9s %4dx%-4d %-11s %8.0f %8.1f %8.1f %8.1f %8.1f %7.1f %7.1f %3d/%-3d %8.1f %8.1f %6.2f\n",
+            scene.Name, modeName, width, height, samplings[s].Name, Mean(result.PointCounts),
+            Mean(result.CloudTimes), Mean(result.DetectionTimes), Mean(result.TrackingTimes), Percentile(result.TotalTimes, 0.95),
+            meanTotal > 0 ? 1e6 / meanTotal : 0.0, meanTotal > 0 ? Mean(result.PointCounts) / meanTotal : 0.0,
+            result.CorrectCount, result.FrameCount, Mean(result.FloorErrors), maxFloorError, Mean(result.NormalErrors));
+    }
+
+    k4a_image_release(depthImage);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<char> rawCalibration;
+    if (argc > 1)
+    {
+        std::ifstream file(argv[1], std::ios::binary);
+        EXIT_IF(!file, "Cannot open the raw calibration file!");
+        rawCalibration.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        // The raw calibration is a zero terminated json string.
+        if (rawCalibration.empty() || rawCalibration.back() != 0)
+        {
+            rawCalibration.push_back(0);
+        }
+    }
+
+    struct DepthMode
+    {
+        const char* Name;
+        k4a_depth_mode_t Mode;
+    };
+    const DepthMode depthModes[] = {
+        { "NFOV 2x2", K4A_DEPTH_MODE_NFOV_2X2BINNED },
+        { "NFOV", K4A_DEPTH_MODE_NFOV_UNBINNED },
+        { "WFOV 2x2", K4A_DEPTH_MODE_WFOV_2X2BINNED },
+        { "WFOV", K4A_DEPTH_MODE_WFOV_UNBINNED },
+    };
+
+    Samples::ThreadPool threadPool;
+    printf("%d frames per scene, %zu threads, %s calibration\n", FrameCount, threadPool.GetThreadCount(),
+        rawCalibration.empty() ? "synthetic" : argv[1]);
+    printf("Times in us, throughput in frames/s and points/us, floor errors in mm, normal error in degrees.\n");
+    printf("%-16s %-9s %-9s %-11s %8s %8s %8s %8s %8s %7s %7s %7s %8s %8s %6s\n",
+        "scene", "mode", "size", "sampling", "points", "cloud", "detect", "track", "p95", "fps", "pts/us", "correct", "floor", "max", "normal");
+
+    for (const Scene& scene : CreateScenes())
+    {
+        for (const DepthMode& depthMode : depthModes)
+        {
+            k4a_calibration_t calibration = Samples::CreateSyntheticCalibration(depthMode.Mode);
+            if (!rawCalibration.empty())
+            {
+                EXIT_IF(!TryLoadCalibration(rawCalibration, depthMode.Mode, calibration), "Invalid raw calibration!");
+            }
+            RunScene(depthMode.Name, calibration, scene, threadPool);
+        }
+    }
+    return 0;
+}
@@ -6,7 +6,9 @@
 #include <k4a/k4a.h>
 
 #include "FloorDetector.h"
+#include "GravityEstimator.h"
 #include "PointCloudGenerator.h"
+#include "PointSampler.h"
 #include "Utilities.h"
 #include "Window3dWrapper.h"
 
@@ -21,11 +23,13 @@ void PrintAppUsage()
     printf(" Key Shortcuts\n\n");
     printf(" ESC: quit\n");
     printf(" h: help\n");
+    printf(" t: toggle temporal floor tracking\n");
     printf("\n");
 }
 
 // Global State and Key Process Function
 bool s_isRunning = true;
+bool s_isFloorTrackingEnabled = true;
 
 int64_t ProcessKey(void* /*context*/, int key)
 {
@@ -39,6 +43,10 @@ int64_t ProcessKey(void* /*context*/, int key)
     case GLFW_KEY_H:
         PrintAppUsage();
         break;
+    case GLFW_KEY_T:
+        s_isFloorTrackingEnabled = !s_isFloorTrackingEnabled;
+        printf("Temporal floor tracking %s\n", s_isFloorTrackingEnabled ? "enabled" : "disabled");
+        break;
     }
     return 1;
 }
@@ -67,8 +75,10 @@ int main()
     VERIFY(k4a_device_get_calibration(device, deviceConfig.depth_mode, deviceConfig.color_resolution, &sensorCalibration),
         "Get depth camera calibration failed!");
 
-    // Start imu for gravity vector.
+    // Start imu for gravity vector. The gravity estimator reads all the IMU samples on its own thread.
     VERIFY(k4a_device_start_imu(device), "Start IMU failed!");
+    Samples::GravityEstimator gravityEstimator{ sensorCalibration };
+    gravityEstimator.Start(device);
 
     // Initialize the 3d window controller.
     Window3dWrapper window3d;
@@ -80,6 +90,17 @@ int main()
     Samples::PointCloudGenerator pointCloudGenerator{ sensorCalibration };
     Samples::FloorDetector floorDetector;
 
+    // About the same number of points in every depth mode, mostly below the horizon where the floor can be seen, and
+    // fewer while the floor is tracked.
+    Samples::PointSampler pointSampler{ sensorCalibration };
+
+    // Threads for the point cloud conversion and the floor search of large clouds, e.g. with a large point budget in
+    // WFOV unbinned mode.
+    Samples::ThreadPool threadPool;
+    pointCloudGenerator.SetThreadPool(&threadPool);
+    Samples::ParallelOptions parallelOptions;
+    parallelOptions.Pool = &threadPool;
+
     while (s_isRunning)
     {
         k4a_capture_t sensorCapture = nullptr;
@@ -89,20 +110,35 @@ int main()
         {
             k4a_image_t depthImage = k4a_capture_get_depth_image(sensorCapture);
 
-            // Capture an IMU sample for sensor orientation.
-            k4a_imu_sample_t imu_sample;
-            if (k4a_device_get_imu_sample(device, &imu_sample, 0) == K4A_WAIT_RESULT_SUCCEEDED)
+            // Latest gravity from the IMU stream, for sensor orientation.
+            Samples::GravitySnapshot gravity = gravityEstimator.GetSnapshot();
+            if (gravity.IsValid)
             {
                 // Update point cloud.
                 pointCloudGenerator.Update(depthImage);
 
-                // Get down-sampled cloud points.
-                const int downsampleStep = 2;
-                const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(downsampleStep);
-
                 // Detect floor plane based on latest visual and inertial observations.
-                const size_t minimumFloorPointCount = 1024 / (downsampleStep * downsampleStep);
-                const auto& maybeFloorPlane = floorDetector.TryDetectFloorPlane(cloudPoints, imu_sample, sensorCalibration, minimumFloorPointCount);
+                // Up normal is opposite to gravity down vector.
+                Samples::Vector up = gravity.Gravity * -1;
+
+                // Get the sampled cloud points and their elevations in a single pass.
+                const auto& cloudPoints = pointCloudGenerator.GetCloudPoints(up, pointSampler.GetRegions(up));
+                const auto& elevations = pointCloudGenerator.GetElevations();
+
+                // A floor of at least 1024 pixels of the depth image, sampled as densely as the floor rows.
+                const size_t minimumFloorPointCount = static_cast<size_t>(1024 * pointSampler.GetFloorSampledRatio());
+
+                // The device is moving, the floor has to be searched again.
+                if (gravity.IsMoving)
+                {
+                    floorDetector.ResetTracking();
+                }
+
+                // While tracking, the floor of the previous frame is only verified instead of searched again.
+                std::optional<Samples::Plane> maybeFloorPlane = s_isFloorTrackingEnabled ?
+                    floorDetector.TrackFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions) :
+                    floorDetector.TryDetectFloorPlane(cloudPoints, elevations, up, minimumFloorPointCount, parallelOptions);
+                pointSampler.UpdateBudget(s_isFloorTrackingEnabled && floorDetector.IsTracking());
 
                 // Visualize point cloud.
                 window3d.UpdatePointClouds(depthImage);
@@ -140,6 +176,7 @@ int main()
 
     window3d.Delete();
 
+    gravityEstimator.Stop();
     k4a_device_stop_cameras(device);
     k4a_device_stop_imu(device);
     k4a_device_close(device);
@@ -4,113 +4,6 @@
 #include "DigitalSignalProcessing.h"
 
 #include <cmath>
-#include <limits>
-
-std::vector<float> DSP::MovingAverage(const std::vector<float>& signal, size_t numOfPoints)
-{
-    if (numOfPoints > signal.size())
-    {
-        return std::vector<float>();
-    }
-
-    if (signal.size() == 1)
-    {
-        return signal;
-    }
-    std::vector<float> cumSum(signal.size());
-
-    std::vector<float> window(numOfPoints);
-    std::vector<float> filteredSignal(signal.size());
-
-    int windowIndex = 0;
-
-    for (size_t i = 0; i < signal.size(); i++)
-    {
-        window[windowIndex] = signal[i] / numOfPoints;
-        float currentMean = 0.0f;
-        for (size_t j = 0; j < numOfPoints; j++)
-        {
-            currentMean = currentMean + window[j];
-        }
-        filteredSignal[i] = currentMean;
-        windowIndex = (windowIndex + 1) % numOfPoints;
-    }
-    return filteredSignal;
-}
-
-std::vector<float> DSP::FirstDerivate(const std::vector<float>& signal)
-{
-    std::vector<float> outputSignal(signal.size() - 1);
-
-    for (size_t i = 1; i < signal.size(); i++)
-    {
-        outputSignal[i - 1] = signal[i] - signal[i - 1];
-    }
-    return outputSignal;
-}
-
-std::vector<float> DSP::DivideTwoArrays(std::vector<float>& dividend, std::vector<float>& divisor)
-{
-    if (dividend.size() != divisor.size())
-    {
-        return std::vector<float>();
-    }
-
-    std::vector<float> result(dividend.size());
-
-    for (size_t i = 0; i < dividend.size(); i++)
-    {
-        if (divisor[i] == 0)
-        {
-            result[i] = 0;
-        }
-        else
-        {
-            result[i] = dividend[i] / divisor[i];
-        }
-    }
-    return result;
-}
-
-IndexValueTuple DSP::FindMaximum(const std::vector<float>& signal, size_t minIdx, size_t maxIdx)
-{
-    if (minIdx > signal.size() || minIdx > signal.size() || minIdx > maxIdx)
-    {
-        return IndexValueTuple();
-    }
-    float maxValue = std::numeric_limits<float>::min();
-    int maxIndex = 0;
-
-    for (size_t i = minIdx; i < maxIdx; i++)
-    {
-        if (signal[i] > maxValue)
-        {
-            maxValue = signal[i];
-            maxIndex = static_cast<int>(i);
-        }
-    }
-    return { maxIndex, maxValue };
-}
-
-IndexValueTuple DSP::FindMinimum(const std::vector<float>& signal, size_t minIdx, size_t maxIdx)
-{
-    if (minIdx > signal.size() || minIdx > signal.size() || minIdx > maxIdx)
-    {
-        return IndexValueTuple();
-    }
-    float minValue = std::numeric_limits<float>::max();
-    int minIndex = 0;
-
-    for (size_t i = minIdx; i < maxIdx; i++)
-    {
-        if (signal[i] < minValue)
-        {
-            minValue = signal[i];
-            minIndex = static_cast<int>(i);
-        }
-    }
-    return { minIndex, minValue };
-}
 
 float DSP::Angle(k4a_float3_t A, k4a_float3_t B, k4a_float3_t C)
 {
@@ -17,5 +17,5 @@ private:
     bool m_bothHandsAreRaised = false;
     std::chrono::microseconds m_handRaisedTimeSpan = std::chrono::microseconds::zero();
     std::chrono::microseconds m_previousTimestamp = std::chrono::microseconds::zero();
-    const std::chrono::seconds m_stableTime = std::chrono::seconds(2);
+    static constexpr std::chrono::seconds m_stableTime = std::chrono::seconds(2);
 };
\ No newline at end of file
@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "JumpDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::optional<JumpResultsData> JumpDetector::UpdateData(const k4abt_body_t& body, uint64_t currentTimestampUsec)
+{
+    const int frameIndex = ++m_frameIndex;
+
+    // Y direction of the sensor coordinate is pointing down. We need to inverse the Y direction to make sure it
+    // points towards the jump direction
+    FrameInfo frame;
+    frame.TimestampUsec = currentTimestampUsec;
+    frame.Height = -body.skeleton.joints[K4ABT_JOINT_PELVIS].position.xyz.y;
+    frame.Pelvis = body.skeleton.joints[K4ABT_JOINT_PELVIS].position;
+    frame.AnkleY = (body.skeleton.joints[K4ABT_JOINT_ANKLE_LEFT].position.xyz.y +
+        body.skeleton.joints[K4ABT_JOINT_ANKLE_RIGHT].position.xyz.y) / 2.f;
+
+    // Filtered height and vertical velocity in mm per second
+    const float UsecToSecond = 1e-6f;
+    float height = m_heightFilter.Update(frame.Height);
+    m_heightDerivative.Update(std::chrono::microseconds(currentTimestampUsec), height);
+    float velocity = m_heightDerivative.GetVelocity() / UsecToSecond;
+    frame.Velocity = velocity;
+    m_history.Push(frame);
+
+    if (!m_heightFilter.IsValid() || !m_heightDerivative.IsValid())
+    {
+        return std::nullopt;
+    }
+
+    // Give up on jumps that do not land, e.g. when the body is lost in the middle of one
+    if (m_phase != JumpPhase::Standing && currentTimestampUsec - m_jumpStart.TimestampUsec > MaximumJumpDurationInUsec)
+    {
+        m_phase = JumpPhase::Standing;
+    }
+
+    switch (m_phase)
+    {
+    case JumpPhase::Standing:
+        if (std::abs(velocity) < QuietVelocity)
+        {
+            m_standingHeight = height;
+            m_hasStandingHeight = true;
+        }
+        else if (m_hasStandingHeight && height < m_standingHeight - CountermovementDepth && velocity < 0 && TryStartJump())
+        {
+            m_squat = { frameIndex, height };
+            m_squatAnkleY = frame.AnkleY;
+            m_squatKneeAngle = GetMinKneeAngleFromBody(body);
+            m_maxVelocity = velocity;
+            m_phase = JumpPhase::Countermovement;
+        }
+        break;
+
+    case JumpPhase::Countermovement:
+        m_maxVelocity = std::max(m_maxVelocity, velocity);
+        if (height < m_squat.Value)
+        {
+            m_squat = { frameIndex, height };
+            m_squatAnkleY = frame.AnkleY;
+            m_squatKneeAngle = GetMinKneeAngleFromBody(body);
+        }
+
+        if (height > m_startHeight + MinimumJumpHeight)
+        {
+            m_peak = { frameIndex, height };
+            m_phase = JumpPhase::Flight;
+        }
+        else if (height > m_startHeight - StandingTolerance && std::abs(velocity) < QuietVelocity)
+        {
+            // Back to standing without jumping, e.g. a squat
+            m_phase = JumpPhase::Standing;
+        }
+        break;
+
+    case JumpPhase::Flight:
+        m_maxVelocity = std::max(m_maxVelocity, velocity);
+        if (height > m_peak.Value)
+        {
+            m_peak = { frameIndex, height };
+        }
+        else if (height < m_peak.Value - PeakDropHeight)
+        {
+            m_landing = { frameIndex, height };
+            m_phase = JumpPhase::Landing;
+        }
+        break;
+
+    case JumpPhase::Landing:
+        if (height < m_landing.Value)
+        {
+            m_landing = { frameIndex, height };
+        }
+
+        // Back on the floor and done with the landing squat
+        if (height < m_startHeight + MinimumJumpHeight && velocity >= -QuietVelocity)
+        {
+            m_phase = JumpPhase::Standing;
+            return FinishJump();
+        }
+        break;
+    }
+    return std::nullopt;
+}
+
+void JumpDetector::Reset()
+{
+    m_heightFilter.Reset();
+    m_heightDerivative.Reset();
+    m_history.Clear();
+    m_frameIndex = -1;
+    m_phase = JumpPhase::Standing;
+    m_hasStandingHeight = false;
+    m_standingHeight = 0;
+}
+
+bool JumpDetector::TryStartJump()
+{
+    // The jump starts at the last frame before the countermovement where the body did not move down yet
+    size_t startIndex = m_history.Size() - 1;
+    while (startIndex > 0 && m_history[startIndex].Velocity < -QuietVelocity)
+    {
+        startIndex--;
+    }
+    m_jumpStart = m_history[startIndex];
+
+    // Average the height of the stable time before the jump start
+    size_t i = startIndex;
+    while (i > 0 && m_jumpStart.TimestampUsec - m_history[i].TimestampUsec < StableTimeInUsec)
+    {
+        i--;
+    }
+    if (i == startIndex || m_jumpStart.TimestampUsec - m_history[i].TimestampUsec < StableTimeInUsec)
+    {
+        return false;
+    }
+
+    float sum = 0;
+    for (size_t j = i; j < startIndex; j++)
+    {
+        sum += m_history[j].Height;
+    }
+    m_startHeight = sum / (startIndex - i);
+    return true;
+}
+
+JumpResultsData JumpDetector::FinishJump() const
+{
+    JumpResultsData jumpResults;
+    jumpResults.JumpSuccess = true;
+    jumpResults.Height = m_peak.Value - m_startHeight;
+    jumpResults.PreparationSquatDepth = m_squat.Value - m_startHeight;
+    jumpResults.LandingSquatDepth = m_landing.Value - m_startHeight;
+    jumpResults.PushOffVelocity = m_maxVelocity;
+    jumpResults.KneeAngle = m_squatKneeAngle;
+    jumpResults.StandingPosition = { m_jumpStart.Pelvis.xyz.x, (m_jumpStart.AnkleY + m_squatAnkleY) / 2.f, m_jumpStart.Pelvis.xyz.z };
+    jumpResults.PeakIndex = m_peak.Index;
+    jumpResults.SquatPointIndex = m_squat.Index;
+    return jumpResults;
+}
+
+float JumpDetector::GetMinKneeAngleFromBody(const k4abt_body_t& body) const
+{
+    k4a_float3_t footLeft = body.skeleton.joints[K4ABT_JOINT_ANKLE_LEFT].position;
+    k4a_float3_t kneeLeft = body.skeleton.joints[K4ABT_JOINT_KNEE_LEFT].position;
+    k4a_float3_t torzoLeft = body.skeleton.joints[K4ABT_JOINT_HIP_LEFT].position;
+
+    k4a_float3_t footRight = body.skeleton.joints[K4ABT_JOINT_ANKLE_RIGHT].position;
+    k4a_float3_t kneeRight = body.skeleton.joints[K4ABT_JOINT_KNEE_RIGHT].position;
+    k4a_float3_t torzoRight = body.skeleton.joints[K4ABT_JOINT_HIP_RIGHT].position;
+
+    float leftKneeAngle = 180 - DSP::Angle(torzoLeft, kneeLeft, footLeft);
+    float rightKneeAngle = 180 - DSP::Angle(torzoRight, kneeRight, footRight);
+    return std::min(leftKneeAngle, rightKneeAngle);
+}
@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <optional>
+
+#include <k4abttypes.h>
+
+#include "DigitalSignalProcessing.h"
+#include "StreamingSignalProcessing.h"
+
+struct JumpResultsData
+{
+    // Jump analysis results
+    float Height = 0;
+    float PreparationSquatDepth = 0;
+    float LandingSquatDepth = 0;
+    float PushOffVelocity = 0;
+    float KneeAngle = 0;
+
+    // Fields that help to visualize the results. The indices count the frames since JumpDetector::Reset().
+    k4a_float3_t StandingPosition;
+    int PeakIndex = 0;
+    int SquatPointIndex = 0;
+    bool JumpSuccess = false;
+};
+
+// Detects jumps online from the pelvis height of every frame, with a state machine over the filtered height and
+// vertical velocity: standing, countermovement, flight and landing. Every update costs the same whatever the length of
+// the session, and the results of a jump are ready a few frames after its landing.
+class JumpDetector
+{
+public:
+    // Adds the body of the next frame. Returns the results of a jump on the frame its landing is detected.
+    std::optional<JumpResultsData> UpdateData(const k4abt_body_t& body, uint64_t currentTimestampUsec);
+
+    // Forgets the previous frames, the frame indices of the results start from 0 again.
+    void Reset();
+
+private:
+    enum class JumpPhase
+    {
+        Standing = 0,
+        Countermovement,
+        Flight,
+        Landing
+    };
+
+    struct FrameInfo
+    {
+        uint64_t TimestampUsec = 0;
+        float Height = 0;
+        float Velocity = 0;
+        k4a_float3_t Pelvis = {};
+        float AnkleY = 0;     // Mean y of the two ankles
+    };
+
+    // Looks back from the start of the countermovement for the last quiet frame, where the jump starts, and averages
+    // the height before it. Returns false when the history does not reach far enough back.
+    bool TryStartJump();
+
+    JumpResultsData FinishJump() const;
+
+    float GetMinKneeAngleFromBody(const k4abt_body_t& body) const;
+
+private:
+    // Constant settings for digital signal processing
+    static constexpr size_t AverageFilterWindowSize = 6;
+    static constexpr size_t HistorySize = 64;                      // About 2 seconds at 30 frames per second
+    static constexpr uint64_t StableTimeInUsec = 200000;           // Standing time averaged for the start height
+    static constexpr uint64_t MaximumJumpDurationInUsec = 3000000; // From the countermovement to the landing
+
+    // Thresholds of the jump phases, in mm and mm per second
+    static constexpr float QuietVelocity = 50.f;
+    static constexpr float CountermovementDepth = 40.f;
+    static constexpr float MinimumJumpHeight = 50.f;
+    static constexpr float PeakDropHeight = 20.f;
+    static constexpr float StandingTolerance = 10.f;
+
+    DSP::StreamingMovingAverage m_heightFilter{ AverageFilterWindowSize };
+    DSP::StreamingDerivative m_heightDerivative;
+    DSP::RingBuffer<FrameInfo> m_history{ HistorySize };
+    int m_frameIndex = -1;
+
+    JumpPhase m_phase = JumpPhase::Standing;
+    bool m_hasStandingHeight = false;
+    float m_standingHeight = 0;
+
+    // State of the current jump
+    FrameInfo m_jumpStart;
+    float m_startHeight = 0;
+    IndexValueTuple m_squat;
+    IndexValueTuple m_peak;
+    IndexValueTuple m_landing;
+    float m_squatAnkleY = 0;
+    float m_squatKneeAngle = 0;
+    float m_maxVelocity = 0;
+};
@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "JumpEvaluationManager.h"
+
+#include <iostream>
+
+JumpEvaluationManager::JumpEvaluationManager()
+{
+    m_bodyIds.reserve(InitialSlotCount);
+    m_lastSeenFrames.reserve(InitialSlotCount);
+    m_evaluators.reserve(InitialSlotCount);
+}
+
+void JumpEvaluationManager::UpdateStatus(bool changeStatus)
+{
+    for (size_t slot = 0; slot < m_bodyIds.size(); slot++)
+    {
+        if (m_bodyIds[slot] != K4ABT_INVALID_BODY_ID)
+        {
+            m_evaluators[slot].UpdateStatus(changeStatus);
+        }
+    }
+}
+
+void JumpEvaluationManager::UpdateData(const std::vector<k4abt_body_t>& bodies, uint64_t currentTimestampUsec)
+{
+    m_frameIndex++;
+
+    for (const k4abt_body_t& body : bodies)
+    {
+        int slot = FindSlot(body.id);
+        if (slot < 0)
+        {
+            slot = AcquireSlot(body.id);
+        }
+
+        m_lastSeenFrames[slot] = m_frameIndex;
+        if (m_evaluators[slot].UpdateData(body, currentTimestampUsec))
+        {
+            // The review is rendered by the main loop with a copy of the session, the body is evaluated on as usual
+            m_reviewer.ReviewJumpResults(m_evaluators[slot].GetSession(), m_evaluators[slot].GetLastJumpResults());
+        }
+    }
+
+    EvictStaleBodies();
+}
+
+bool JumpEvaluationManager::IsCollectingJumpData(uint32_t bodyId) const
+{
+    int slot = FindSlot(bodyId);
+    return slot >= 0 && m_evaluators[slot].IsCollectingJumpData();
+}
+
+int JumpEvaluationManager::FindSlot(uint32_t bodyId) const
+{
+    for (size_t slot = 0; slot < m_bodyIds.size(); slot++)
+    {
+        if (m_bodyIds[slot] == bodyId)
+        {
+            return static_cast<int>(slot);
+        }
+    }
+    return -1;
+}
+
+int JumpEvaluationManager::AcquireSlot(uint32_t bodyId)
+{
+    int slot = FindSlot(K4ABT_INVALID_BODY_ID);
+    if (slot < 0)
+    {
+        slot = static_cast<int>(m_bodyIds.size());
+        m_bodyIds.push_back(K4ABT_INVALID_BODY_ID);
+        m_lastSeenFrames.push_back(0);
+        m_evaluators.emplace_back();
+    }
+
+    m_bodyIds[slot] = bodyId;
+    m_evaluators[slot].Reset(bodyId);
+    return slot;
+}
+
+void JumpEvaluationManager::EvictStaleBodies()
+{
+    for (size_t slot = 0; slot < m_bodyIds.size(); slot++)
+    {
+        if (m_bodyIds[slot] != K4ABT_INVALID_BODY_ID && m_frameIndex - m_lastSeenFrames[slot] > StaleFrameCount)
+        {
+            if (m_evaluators[slot].IsCollectingJumpData())
+            {
+                std::cout << "Body " << m_bodyIds[slot] << " left the scene, its jump session is dropped!" << std::endl;
+            }
+            m_bodyIds[slot] = K4ABT_INVALID_BODY_ID;
+        }
+    }
+}
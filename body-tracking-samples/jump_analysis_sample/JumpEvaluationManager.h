@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <vector>
+#include <k4abt.h>
+
+#include "JumpEvaluator.h"
+#include "JumpReviewer.h"
+
+// Jump evaluation of every body in the scene, with one JumpEvaluator per body id. The table is a set of flat arrays
+// indexed by slot: the body ids and last seen frames scanned every frame are contiguous, apart from the evaluators. A
+// body that is not seen for StaleFrameCount frames is evicted and its slot is reused for the next new body, with the
+// memory of its session, so the table stays as large as the largest group of bodies seen at once.
+class JumpEvaluationManager
+{
+public:
+    JumpEvaluationManager();
+
+    // Starts or ends the session of every tracked body.
+    void UpdateStatus(bool changeStatus);
+
+    // Updates the evaluators of all the bodies of a frame in one pass, queues the review of the sessions that ended in
+    // this frame and evicts the bodies that left the scene.
+    void UpdateData(const std::vector<k4abt_body_t>& bodies, uint64_t currentTimestampUsec);
+
+    bool IsCollectingJumpData(uint32_t bodyId) const;
+
+    // Renders the review windows of the sessions that ended, see JumpReviewer::Render(). Called once per iteration of
+    // the main loop, on the main thread.
+    void RenderReview() { m_reviewer.Render(); }
+
+private:
+    int FindSlot(uint32_t bodyId) const;
+
+    int AcquireSlot(uint32_t bodyId);
+
+    void EvictStaleBodies();
+
+private:
+    // Number of frames a body can be missing, e.g. occluded, before its session is dropped. About one second at 30
+    // frames per second.
+    static constexpr uint64_t StaleFrameCount = 30;
+
+    // Slots reserved up front, bodies in the field of view of a typical group session
+    static constexpr size_t InitialSlotCount = 6;
+
+    uint64_t m_frameIndex = 0;
+
+    // One entry per slot, the body id is K4ABT_INVALID_BODY_ID for a free slot
+    std::vector<uint32_t> m_bodyIds;
+    std::vector<uint64_t> m_lastSeenFrames;
+    std::vector<JumpEvaluator> m_evaluators;
+
+    JumpReviewer m_reviewer;
+};
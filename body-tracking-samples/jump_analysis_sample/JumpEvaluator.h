@@ -3,11 +3,11 @@
 
 #pragma once
 
-#include <vector>
-#include <k4abt.h>
+#include <k4abttypes.h>
 
 #include "HandRaisedDetector.h"
-#include "Window3dWrapper.h"
+#include "JumpDetector.h"
+#include "JumpSessionStore.h"
 
 enum JumpStatus
 {
@@ -16,68 +16,41 @@ enum JumpStatus
     EvaluateAndReview
 };
 
-struct IndexValueTuple;
-struct JumpResultsData;
-
+// Jump session of one body: the hand raise detection that starts and ends it, the frames of the session and the jumps
+// detected in it. The review windows are shared by all the bodies, see JumpReviewer.
 class JumpEvaluator
 {
 public:
+    // Starts over for a new body, keeping the memory of the session store.
+    void Reset(uint32_t bodyId);
+
     void UpdateStatus(bool changeStatus);
-    void UpdateData(k4abt_body_t selectedBody, uint64_t currentTimestampUsec);
+
+    // Returns true when the session of the body ended with a jump to review, see GetSession() and GetLastJumpResults().
+    bool UpdateData(const k4abt_body_t& selectedBody, uint64_t currentTimestampUsec);
+
+    bool IsCollectingJumpData() const { return m_jumpStatus == JumpStatus::CollectJumpData; }
+    const JumpSessionStore& GetSession() const { return m_session; }
+    const JumpResultsData& GetLastJumpResults() const { return m_lastJumpResults; }
 
 private:
     void InitiateJump();
 
-    JumpResultsData CalculateJumpResults();
-
     void PrintJumpResults(const JumpResultsData& jumpResults);
 
-    void ReviewJumpResults(const JumpResultsData& jumpResults);
-
-    std::vector<float> GetInverseHeightInfoFromBodies(k4abt_joint_id_t jointId);
-
-    int DetermineCalculationWindowWidth(int jumpStartIndex, const std::vector<float>& timeStampInUsec);
-
-    float GetMinKneeAngleFromBody(k4abt_body_t body);
-
-    IndexValueTuple CalcualateJumpStartingPoint(const std::vector<float>& velocity, const std::vector<IndexValueTuple>& velocityPhases);
-
-    IndexValueTuple CalcualateJumpEndingPoint(const std::vector<float>& velocity, const std::vector<IndexValueTuple>& velocityPhases);
-
-    // Calculate characteristic points of velocity signal
-    std::vector<IndexValueTuple> CalculatePhasesFromVelocity(const std::vector<float>& velocity);
-
-    float CalculateStartHeight(std::vector<float> signal, size_t startingPoint = 10, size_t endingPoint = 30);
-
-    k4a_float3_t CalculateStandingPosition(int jumpStartIndex, int firstSquatIndex);
-
-    void CreateRenderWindow(
-        Window3dWrapper& window,
-        std::string windowName,
-        const k4abt_body_t& body,
-        int windowIndex,
-        k4a_float3_t standingPosition);
-
 private:
-    // Constant settings for digial signal processing
-    const size_t MinimumBodyNumber = 20;  // Minimum number of bodies required in the body list to perform the jump analysis
-    const int AverageFilterWindowSize = 6;
-
     // Internal status
-    bool m_reviewWindowIsRunning = false;
+    uint32_t m_bodyId = K4ABT_INVALID_BODY_ID;
     JumpStatus m_jumpStatus = JumpStatus::Idle;
 
-    std::vector<k4abt_body_t> m_listOfBodyPositions;
-    std::vector<float> m_framesTimestampInUsec;
+    // Frames of the current session for the review, with quantized skeletons for the replay
+    JumpSessionStore m_session{ SkeletonStorage::Quantized };
+
+    // Jumps of the current session, detected as the frames arrive
+    JumpDetector m_jumpDetector;
+    int m_jumpCount = 0;
+    JumpResultsData m_lastJumpResults;
 
     HandRaisedDetector m_handRaisedDetector;
     bool m_previousHandsAreRaised = false;
-
-    // Default jump analysis window size
-    const int m_defaultWindowWidth = 640;
-    const int m_defaultWindowHeight = 576;
-
-    Window3dWrapper m_window3dSquatPose;
-    Window3dWrapper m_window3dJumpPeakPose;
-    Window3dWrapper m_window3dReplay;
 };
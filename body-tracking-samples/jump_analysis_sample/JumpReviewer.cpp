@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "JumpReviewer.h"
+
+using namespace Visualization;
+using namespace std::chrono;
+
+void JumpReviewer::ReviewJumpResults(const JumpSessionStore& session, const JumpResultsData& jumpResults)
+{
+    // The session is copied here, the evaluator can start its next session while the copy is reviewed
+    m_pendingReviews.push_back(Review{ session, jumpResults });
+}
+
+void JumpReviewer::Render()
+{
+    if (!m_isReviewing)
+    {
+        if (m_pendingReviews.empty())
+        {
+            return;
+        }
+        StartReview(m_pendingReviews.front());
+    }
+
+    if (!m_reviewWindowIsRunning)
+    {
+        EndReview();
+        return;
+    }
+
+    // The windows are rendered at the rate of the replay, so the review costs the main loop about 30 frames per second
+    // whatever its own rate
+    auto now = high_resolution_clock::now();
+    if (now - m_lastReplayFrameTime < m_expectedFrameDuration)
+    {
+        return;
+    }
+    m_lastReplayFrameTime = now;
+
+    const JumpSessionStore& session = m_pendingReviews.front().Session;
+    const size_t frameCount = session.GetFrameCount();
+    m_currentReplayIndex = (m_currentReplayIndex + 1) % frameCount;
+
+    // Try to skip one frame if we detected a flip
+    if (session.GetAnalysisJointPosition(m_currentReplayIndex, AnalysisJoint::AnkleLeft).xyz.x <=
+        session.GetAnalysisJointPosition(m_currentReplayIndex, AnalysisJoint::AnkleRight).xyz.x)
+    {
+        m_currentReplayIndex = (m_currentReplayIndex + 1) % frameCount;
+    }
+
+    m_window3dReplay.CleanJointsAndBones();
+    m_window3dReplay.AddBody(session.GetBody(m_currentReplayIndex), g_bodyColors[0]);
+
+    m_window3dSquatPose.Render();
+    m_window3dJumpPeakPose.Render();
+    m_window3dReplay.Render();
+}
+
+void JumpReviewer::StartReview(const Review& review)
+{
+    const JumpSessionStore& session = review.Session;
+    const JumpResultsData& jumpResults = review.JumpResults;
+    const std::string bodyName = "Body " + std::to_string(session.GetBodyId()) + " ";
+
+    CreateRenderWindow(m_window3dSquatPose, bodyName + "Squat Pose", session.GetBody(jumpResults.SquatPointIndex), 0, jumpResults.StandingPosition);
+    CreateRenderWindow(m_window3dJumpPeakPose, bodyName + "Jump Peak Pose", session.GetBody(jumpResults.PeakIndex), 1, jumpResults.StandingPosition);
+    CreateRenderWindow(m_window3dReplay, bodyName + "Replay", session.GetBody(0), 2, jumpResults.StandingPosition);
+
+    m_currentReplayIndex = 0;
+    m_lastReplayFrameTime = high_resolution_clock::time_point();
+    m_reviewWindowIsRunning = true;
+    m_isReviewing = true;
+}
+
+void JumpReviewer::EndReview()
+{
+    m_window3dSquatPose.Delete();
+    m_window3dJumpPeakPose.Delete();
+    m_window3dReplay.Delete();
+
+    m_pendingReviews.pop_front();
+    m_isReviewing = false;
+}
+
+int64_t ReviewWindowCloseCallback(void* context)
+{
+    bool* running = (bool*)context;
+    *running = false;
+    return 1;
+}
+
+void JumpReviewer::CreateRenderWindow(
+    Window3dWrapper& window,
+    std::string windowName,
+    const k4abt_body_t& body,
+    int windowIndex,
+    k4a_float3_t standingPosition)
+{
+    // Without vsync, so the review windows do not wait for the display on top of the live window, which would slow
+    // down the body tracking
+    window.Create(windowName.c_str(), K4A_DEPTH_MODE_WFOV_2X2BINNED, m_defaultWindowWidth, m_defaultWindowHeight, false);
+    window.SetCloseCallback(ReviewWindowCloseCallback, &m_reviewWindowIsRunning);
+    window.AddBody(body, g_bodyColors[0]);
+    window.SetFloorRendering(true, standingPosition.v[0] / 1000.f, standingPosition.v[1] / 1000.f, standingPosition.v[2] / 1000.f);
+
+    int xPos = windowIndex * m_defaultWindowWidth;
+    int yPos = 100;
+    window.SetWindowPosition(xPos, yPos);
+}
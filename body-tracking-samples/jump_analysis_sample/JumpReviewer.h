@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <k4abt.h>
+
+#include "JumpDetector.h"
+#include "JumpSessionStore.h"
+#include "Window3dWrapper.h"
+
+// 3d windows showing the squat and peak poses of a jump and a replay of its session. GLFW windows can only be created,
+// rendered and deleted on the main thread, so the review does not run a loop of its own: the main loop calls Render()
+// once per iteration, which renders one frame of the review and returns, and the body tracking keeps running meanwhile.
+class JumpReviewer
+{
+public:
+    // Queues the review of a jump with a copy of its session and returns right away. The reviews are shown one after
+    // the other, each until one of its windows is closed.
+    void ReviewJumpResults(const JumpSessionStore& session, const JumpResultsData& jumpResults);
+
+    // Opens the windows of the next queued review, renders a frame of the current one when its next replay frame is
+    // due and closes its windows once one of them is closed. Must be called from the main thread.
+    void Render();
+
+private:
+    struct Review
+    {
+        JumpSessionStore Session;
+        JumpResultsData JumpResults;
+    };
+
+    void StartReview(const Review& review);
+
+    void EndReview();
+
+    void CreateRenderWindow(
+        Window3dWrapper& window,
+        std::string windowName,
+        const k4abt_body_t& body,
+        int windowIndex,
+        k4a_float3_t standingPosition);
+
+private:
+    // The front review is the one shown while m_isReviewing
+    std::deque<Review> m_pendingReviews;
+    bool m_isReviewing = false;
+
+    // Cleared by the close callback of the windows
+    bool m_reviewWindowIsRunning = false;
+
+    // Replay of the current review, one session frame every m_expectedFrameDuration
+    size_t m_currentReplayIndex = 0;
+    std::chrono::high_resolution_clock::time_point m_lastReplayFrameTime;
+    const std::chrono::milliseconds m_expectedFrameDuration = std::chrono::milliseconds(33);
+
+    // Default jump analysis window size
+    const int m_defaultWindowWidth = 640;
+    const int m_defaultWindowHeight = 576;
+
+    Window3dWrapper m_window3dSquatPose;
+    Window3dWrapper m_window3dJumpPeakPose;
+    Window3dWrapper m_window3dReplay;
+};
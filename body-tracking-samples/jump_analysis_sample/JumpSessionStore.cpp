@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "JumpSessionStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+int16_t QuantizeMillimeters(float value)
+{
+    const float clamped = std::min(std::max(value, static_cast<float>(std::numeric_limits<int16_t>::min())),
+        static_cast<float>(std::numeric_limits<int16_t>::max()));
+    return static_cast<int16_t>(std::lround(clamped));
+}
+
+JumpSessionStore::JumpSessionStore(SkeletonStorage skeletonStorage)
+    : m_skeletonStorage(skeletonStorage)
+{
+}
+
+void JumpSessionStore::Clear()
+{
+    m_bodyId = K4ABT_INVALID_BODY_ID;
+    m_timestampsUsec.clear();
+    m_pelvisHeights.clear();
+    m_analysisJoints.clear();
+    m_quantizedSkeletons.clear();
+    m_skeletons.clear();
+}
+
+void JumpSessionStore::AddBody(const k4abt_body_t& body, uint64_t timestampUsec)
+{
+    if (m_timestampsUsec.empty())
+    {
+        m_bodyId = body.id;
+    }
+    m_timestampsUsec.push_back(timestampUsec);
+
+    // Y direction of the sensor coordinate is pointing down. We need to inverse the Y direction to make sure it
+    // points towards the jump direction
+    m_pelvisHeights.push_back(-body.skeleton.joints[K4ABT_JOINT_PELVIS].position.xyz.y);
+
+    for (k4abt_joint_id_t jointId : AnalysisJointIds)
+    {
+        m_analysisJoints.push_back(body.skeleton.joints[jointId].position);
+    }
+
+    if (m_skeletonStorage == SkeletonStorage::Quantized)
+    {
+        QuantizedSkeleton skeleton;
+        for (int joint = 0; joint < static_cast<int>(K4ABT_JOINT_COUNT); joint++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                skeleton.Positions[joint][axis] = QuantizeMillimeters(body.skeleton.joints[joint].position.v[axis]);
+            }
+            skeleton.ConfidenceLevels[joint] = static_cast<uint8_t>(body.skeleton.joints[joint].confidence_level);
+        }
+        m_quantizedSkeletons.push_back(skeleton);
+    }
+    else if (m_skeletonStorage == SkeletonStorage::Full)
+    {
+        m_skeletons.push_back(body.skeleton);
+    }
+}
+
+k4abt_body_t JumpSessionStore::GetBody(size_t frameIndex) const
+{
+    k4abt_body_t body = {};
+    body.id = m_bodyId;
+
+    if (m_skeletonStorage == SkeletonStorage::Full)
+    {
+        body.skeleton = m_skeletons[frameIndex];
+        return body;
+    }
+
+    for (int joint = 0; joint < static_cast<int>(K4ABT_JOINT_COUNT); joint++)
+    {
+        body.skeleton.joints[joint].orientation.wxyz.w = 1.f;
+    }
+
+    if (m_skeletonStorage == SkeletonStorage::Quantized)
+    {
+        const QuantizedSkeleton& skeleton = m_quantizedSkeletons[frameIndex];
+        for (int joint = 0; joint < static_cast<int>(K4ABT_JOINT_COUNT); joint++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                body.skeleton.joints[joint].position.v[axis] = skeleton.Positions[joint][axis];
+            }
+            body.skeleton.joints[joint].confidence_level = static_cast<k4abt_joint_confidence_level_t>(skeleton.ConfidenceLevels[joint]);
+        }
+    }
+
+    // The analysis joints are always in full precision
+    for (size_t i = 0; i < AnalysisJointIds.size(); i++)
+    {
+        k4abt_joint_t& joint = body.skeleton.joints[AnalysisJointIds[i]];
+        joint.position = GetAnalysisJointPosition(frameIndex, static_cast<AnalysisJoint>(i));
+        if (m_skeletonStorage == SkeletonStorage::None)
+        {
+            joint.confidence_level = K4ABT_JOINT_CONFIDENCE_MEDIUM;
+        }
+    }
+    return body;
+}
+
+size_t JumpSessionStore::GetMemoryUsage() const
+{
+    return m_timestampsUsec.size() * sizeof(uint64_t) +
+        m_pelvisHeights.size() * sizeof(float) +
+        m_analysisJoints.size() * sizeof(k4a_float3_t) +
+        m_quantizedSkeletons.size() * sizeof(QuantizedSkeleton) +
+        m_skeletons.size() * sizeof(k4abt_skeleton_t);
+}
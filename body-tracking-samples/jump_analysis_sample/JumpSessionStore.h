@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <k4abttypes.h>
+
+// Joints read by the jump analysis, stored in full precision for every frame.
+enum class AnalysisJoint
+{
+    Pelvis = 0,
+    HipLeft,
+    KneeLeft,
+    AnkleLeft,
+    HipRight,
+    KneeRight,
+    AnkleRight,
+    Count
+};
+
+const std::array<k4abt_joint_id_t, static_cast<size_t>(AnalysisJoint::Count)> AnalysisJointIds = {
+    K4ABT_JOINT_PELVIS,
+    K4ABT_JOINT_HIP_LEFT,
+    K4ABT_JOINT_KNEE_LEFT,
+    K4ABT_JOINT_ANKLE_LEFT,
+    K4ABT_JOINT_HIP_RIGHT,
+    K4ABT_JOINT_KNEE_RIGHT,
+    K4ABT_JOINT_ANKLE_RIGHT
+};
+
+// How the whole skeleton of every frame is kept for the replay.
+enum class SkeletonStorage
+{
+    // No replay, only the analysis joints are kept
+    None = 0,
+
+    // Joint positions in int16 millimeters and confidence levels, without the joint orientations, which the review
+    // windows do not draw. About a fifth of the size of a k4abt_skeleton_t.
+    Quantized,
+
+    // Every k4abt_skeleton_t as it is
+    Full
+};
+
+// Frames of a jump session of one body as a structure of arrays: the timestamps and the pelvis height in contiguous
+// arrays for the signal processing, the analysis joints in a separate block and the skeletons for the replay, optionally
+// quantized. Clear() keeps the memory for the next session.
+class JumpSessionStore
+{
+public:
+    JumpSessionStore(SkeletonStorage skeletonStorage = SkeletonStorage::Quantized);
+
+    void Clear();
+
+    void AddBody(const k4abt_body_t& body, uint64_t timestampUsec);
+
+    size_t GetFrameCount() const { return m_timestampsUsec.size(); }
+
+    // Body of the session, set by the first AddBody().
+    uint32_t GetBodyId() const { return m_bodyId; }
+
+    // Inverse pelvis y of every frame in mm, pointing towards the jump direction. The arrays of the store itself,
+    // nothing is copied.
+    const std::vector<float>& GetPelvisHeights() const { return m_pelvisHeights; }
+    const std::vector<uint64_t>& GetTimestampsUsec() const { return m_timestampsUsec; }
+
+    k4a_float3_t GetAnalysisJointPosition(size_t frameIndex, AnalysisJoint joint) const
+    {
+        return m_analysisJoints[frameIndex * static_cast<size_t>(AnalysisJoint::Count) + static_cast<size_t>(joint)];
+    }
+
+    // Body of a frame for the replay. Quantized skeletons come back with identity joint orientations. Without
+    // skeletons, only the analysis joints are set.
+    k4abt_body_t GetBody(size_t frameIndex) const;
+
+    // Bytes used by the frames of the session.
+    size_t GetMemoryUsage() const;
+
+private:
+    struct QuantizedSkeleton
+    {
+        int16_t Positions[K4ABT_JOINT_COUNT][3];
+        uint8_t ConfidenceLevels[K4ABT_JOINT_COUNT];
+    };
+
+    SkeletonStorage m_skeletonStorage;
+
+    uint32_t m_bodyId = K4ABT_INVALID_BODY_ID;
+
+    std::vector<uint64_t> m_timestampsUsec;
+    std::vector<float> m_pelvisHeights;
+    std::vector<k4a_float3_t> m_analysisJoints;
+    std::vector<QuantizedSkeleton> m_quantizedSkeletons;
+    std::vector<k4abt_skeleton_t> m_skeletons;
+};
@@ -0,0 +1,189 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "DigitalSignalProcessing.h"
+
+// Streaming signal processing: moving average, derivative and running extrema. Every class takes one sample at a time
+// and updates its output in constant time. All the state lives in ring buffers allocated once with a fixed capacity,
+// nothing is allocated per sample, so the cost per frame does not grow with the length of a session.
+namespace DSP
+{
+    // Fixed capacity FIFO. Push() drops the oldest sample when the buffer is full.
+    template <typename T>
+    class RingBuffer
+    {
+    public:
+        RingBuffer(size_t capacity)
+            : m_buffer(capacity > 0 ? capacity : 1)
+        {
+        }
+
+        void Push(const T& value)
+        {
+            if (m_size == m_buffer.size())
+            {
+                PopFront();
+            }
+            m_buffer[(m_first + m_size) % m_buffer.size()] = value;
+            m_size++;
+        }
+
+        void PopFront()
+        {
+            m_first = (m_first + 1) % m_buffer.size();
+            m_size--;
+        }
+
+        void PopBack() { m_size--; }
+
+        void Clear()
+        {
+            m_first = 0;
+            m_size = 0;
+        }
+
+        // Samples from the oldest, at index 0, to the newest, at Size() - 1.
+        const T& operator[](size_t index) const { return m_buffer[(m_first + index) % m_buffer.size()]; }
+        const T& Front() const { return m_buffer[m_first]; }
+        const T& Back() const { return (*this)[m_size - 1]; }
+
+        size_t Size() const { return m_size; }
+        size_t Capacity() const { return m_buffer.size(); }
+        bool IsEmpty() const { return m_size == 0; }
+        bool IsFull() const { return m_size == m_buffer.size(); }
+
+    private:
+        std::vector<T> m_buffer;
+        size_t m_first = 0;
+        size_t m_size = 0;
+    };
+
+    // Moving average of the last numOfPoints samples with a running sum. The samples before the first one count as 0.
+    class StreamingMovingAverage
+    {
+    public:
+        StreamingMovingAverage(size_t numOfPoints)
+            : m_window(numOfPoints)
+        {
+        }
+
+        float Update(float v)
+        {
+            if (m_window.IsFull())
+            {
+                m_sum -= m_window.Front();
+            }
+            m_window.Push(v);
+
+            // The sum is kept in double precision, so it does not drift over long sessions.
+            m_sum += v;
+            m_average = static_cast<float>(m_sum / m_window.Capacity());
+            return m_average;
+        }
+
+        void Reset()
+        {
+            m_window.Clear();
+            m_sum = 0;
+            m_average = 0;
+        }
+
+        bool IsValid() const { return m_window.IsFull(); }
+        float GetValue() const { return m_average; }
+
+    private:
+        RingBuffer<float> m_window;
+        double m_sum = 0;
+        float m_average = 0;
+    };
+
+    // Difference between consecutive samples and the rate of change over the time between them.
+    class StreamingDerivative
+    {
+    public:
+        void Update(const std::chrono::microseconds& timestamp, float v)
+        {
+            if (m_sampleCount > 0)
+            {
+                m_delta = v - m_value;
+                m_timestampDelta = timestamp - m_timestamp;
+            }
+            m_value = v;
+            m_timestamp = timestamp;
+            m_sampleCount++;
+        }
+
+        void Reset() { *this = StreamingDerivative(); }
+
+        bool IsValid() const { return m_sampleCount > 1; }
+        float GetDelta() const { return m_delta; }
+
+        // Change per microsecond, 0 when the two samples have the same timestamp.
+        float GetVelocity() const
+        {
+            return m_timestampDelta.count() == 0 ? 0.f : m_delta / m_timestampDelta.count();
+        }
+
+    private:
+        float m_value = 0;
+        float m_delta = 0;
+        std::chrono::microseconds m_timestamp = std::chrono::microseconds::zero();
+        std::chrono::microseconds m_timestampDelta = std::chrono::microseconds::zero();
+        size_t m_sampleCount = 0;
+    };
+
+    // Maximum (IsMaximum) or minimum of the last windowSize samples, with a monotonic deque of the samples that can
+    // still become the extremum. Every sample enters and leaves the deque once, so an update costs O(1) amortized.
+    // Ties are resolved to the oldest sample.
+    template <bool IsMaximum>
+    class SlidingExtremum
+    {
+    public:
+        SlidingExtremum(size_t windowSize)
+            : m_candidates(windowSize)
+        {
+        }
+
+        IndexValueTuple Update(float v)
+        {
+            const int index = m_nextIndex++;
+
+            // The oldest candidate leaves the window.
+            if (!m_candidates.IsEmpty() && m_candidates.Front().Index <= index - static_cast<int>(m_candidates.Capacity()))
+            {
+                m_candidates.PopFront();
+            }
+
+            // Candidates beaten by the new sample can never be the extremum again.
+            while (!m_candidates.IsEmpty() && IsBetter(v, m_candidates.Back().Value))
+            {
+                m_candidates.PopBack();
+            }
+            m_candidates.Push({ index, v });
+            return m_candidates.Front();
+        }
+
+        void Reset()
+        {
+            m_candidates.Clear();
+            m_nextIndex = 0;
+        }
+
+        // Extremum of the window, with the index of its sample counted from the first Update() since Reset().
+        IndexValueTuple GetValue() const { return m_candidates.IsEmpty() ? IndexValueTuple() : m_candidates.Front(); }
+
+    private:
+        static bool IsBetter(float a, float b) { return IsMaximum ? a > b : a < b; }
+
+        RingBuffer<IndexValueTuple> m_candidates;
+        int m_nextIndex = 0;
+    };
+
+    using SlidingMaximum = SlidingExtremum<true>;
+    using SlidingMinimum = SlidingExtremum<false>;
+};
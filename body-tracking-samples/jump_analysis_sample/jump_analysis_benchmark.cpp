@@ -0,0 +1,282 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <k4abttypes.h>
+
+#include "JumpDetector.h"
+#include "JumpSessionStore.h"
+#include "StreamingSignalProcessing.h"
+
+// Checks and times the online jump detection on synthetic jump sessions, the memory and the precision of the session
+// store in every skeleton storage, and the running extrema against a search of the whole window.
+// Runs on synthetic bodies, no device is needed. Returns 1 when a check fails.
+
+const float Pi = 3.14159265f;
+const float Gravity = 9810.f;               // mm per second squared
+const uint64_t FrameDurationUsec = 33333;   // 30 frames per second
+
+// Jump of the synthetic sessions, heights of the pelvis in mm and velocities in mm per second
+const float StandingHeight = 300.f;
+const float CountermovementDepth = 250.f;
+const float TakeoffRise = 100.f;
+const float TakeoffVelocity = 2500.f;
+const float LandingDepth = 150.f;
+
+template <typename Function>
+double MeasureMicroseconds(int iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        function();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+}
+
+float Hermite(float p0, float v0, float p1, float v1, float duration, float t)
+{
+    float s = t / duration;
+    float h00 = 2 * s * s * s - 3 * s * s + 1;
+    float h10 = s * s * s - 2 * s * s + s;
+    float h01 = -2 * s * s * s + 3 * s * s;
+    float h11 = s * s * s - s * s;
+    return h00 * p0 + h10 * duration * v0 + h01 * p1 + h11 * duration * v1;
+}
+
+// Pelvis height of every frame of a session with jumpCount jumps: standing, countermovement, push-off, flight, landing
+// and recovery, then standing again until the end.
+std::vector<float> CreateJumpSession(int jumpCount)
+{
+    std::vector<float> heights;
+    const float dt = FrameDurationUsec * 1e-6f;
+    const float flightTime = 2 * TakeoffVelocity / Gravity;
+    for (int j = 0; j < jumpCount; j++)
+    {
+        for (float t = 0; t < 1.5f; t += dt)
+        {
+            heights.push_back(StandingHeight);
+        }
+        for (float t = 0; t < 0.5f; t += dt)
+        {
+            heights.push_back(StandingHeight - CountermovementDepth * (1 - std::cos(Pi * t / 0.5f)) / 2);
+        }
+        for (float t = 0; t < 0.3f; t += dt)
+        {
+            heights.push_back(Hermite(StandingHeight - CountermovementDepth, 0, StandingHeight + TakeoffRise, TakeoffVelocity, 0.3f, t));
+        }
+        for (float t = 0; t < flightTime; t += dt)
+        {
+            heights.push_back(StandingHeight + TakeoffRise + TakeoffVelocity * t - Gravity / 2 * t * t);
+        }
+        for (float t = 0; t < 0.25f; t += dt)
+        {
+            heights.push_back(Hermite(StandingHeight + TakeoffRise, -TakeoffVelocity, StandingHeight - LandingDepth, 0, 0.25f, t));
+        }
+        for (float t = 0; t < 0.6f; t += dt)
+        {
+            heights.push_back(StandingHeight - LandingDepth + LandingDepth * (1 - std::cos(Pi * t / 0.6f)) / 2);
+        }
+    }
+    for (float t = 0; t < 1.f; t += dt)
+    {
+        heights.push_back(StandingHeight);
+    }
+    return heights;
+}
+
+// Body standing 2m in front of the sensor with the given pelvis height, legs bent with it, and noisy joints.
+k4abt_body_t CreateBody(float pelvisHeight, std::mt19937& generator)
+{
+    std::normal_distribution<float> noise(0.f, 3.f);
+    k4abt_body_t body = {};
+    body.id = 1;
+    for (int joint = 0; joint < static_cast<int>(K4ABT_JOINT_COUNT); joint++)
+    {
+        body.skeleton.joints[joint].position = { { joint * 10.f + noise(generator), joint * 5.f + noise(generator), 2000.f + joint } };
+        body.skeleton.joints[joint].orientation.wxyz.w = 1.f;
+        body.skeleton.joints[joint].confidence_level = static_cast<k4abt_joint_confidence_level_t>(joint % 4);
+    }
+
+    // Y direction of the sensor coordinate is pointing down
+    const float y = -(pelvisHeight + noise(generator));
+    body.skeleton.joints[K4ABT_JOINT_PELVIS].position = { { 0.f, y, 2000.f } };
+    body.skeleton.joints[K4ABT_JOINT_HIP_LEFT].position = { { -100.f, y + 20.f, 2000.f } };
+    body.skeleton.joints[K4ABT_JOINT_HIP_RIGHT].position = { { 100.f, y + 20.f, 2000.f } };
+    body.skeleton.joints[K4ABT_JOINT_KNEE_LEFT].position = { { -100.f, (y + 620.f) / 2.f, 2100.f } };
+    body.skeleton.joints[K4ABT_JOINT_KNEE_RIGHT].position = { { 100.f, (y + 620.f) / 2.f, 2100.f } };
+    body.skeleton.joints[K4ABT_JOINT_ANKLE_LEFT].position = { { -100.f, 600.f, 2000.f } };
+    body.skeleton.joints[K4ABT_JOINT_ANKLE_RIGHT].position = { { 100.f, 600.f, 2000.f } };
+    return body;
+}
+
+bool RunJumpDetectorBenchmark()
+{
+    const int jumpCount = 20;
+    std::vector<float> heights = CreateJumpSession(jumpCount);
+    std::mt19937 generator(3);
+    std::vector<k4abt_body_t> bodies;
+    for (float height : heights)
+    {
+        bodies.push_back(CreateBody(height, generator));
+    }
+
+    JumpDetector jumpDetector;
+    int foundCount = 0;
+    float maxHeightError = 0;
+    const float expectedHeight = TakeoffRise + TakeoffVelocity * TakeoffVelocity / (2 * Gravity);
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        auto jumpResults = jumpDetector.UpdateData(bodies[i], i * FrameDurationUsec);
+        if (jumpResults)
+        {
+            foundCount++;
+            maxHeightError = std::max(maxHeightError, std::abs(jumpResults->Height - expectedHeight));
+        }
+    }
+
+    size_t frameIndex = 0;
+    double updateUsec = MeasureMicroseconds(static_cast<int>(bodies.size()), [&]() {
+        jumpDetector.UpdateData(bodies[frameIndex % bodies.size()], frameIndex * FrameDurationUsec);
+        frameIndex++;
+    });
+
+    printf("JumpDetector: %d of %d jumps found in %zu frames, jump height %.1f mm, max error %.1f mm, %.3f us per frame\n",
+        foundCount, jumpCount, bodies.size(), expectedHeight, maxHeightError, updateUsec);
+    return foundCount == jumpCount;
+}
+
+bool RunSessionStoreBenchmark()
+{
+    const size_t frameCount = 900;  // 30 seconds at 30 frames per second
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> position(-2000.f, 4000.f);
+    std::vector<k4abt_body_t> bodies(frameCount);
+    for (k4abt_body_t& body : bodies)
+    {
+        body = CreateBody(position(generator), generator);
+        for (int joint = 0; joint < static_cast<int>(K4ABT_JOINT_COUNT); joint++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                body.skeleton.joints[joint].position.v[axis] = position(generator);
+            }
+        }
+    }
+
+    bool success = true;
+    const SkeletonStorage storages[] = { SkeletonStorage::None, SkeletonStorage::Quantized, SkeletonStorage::Full };
+    const char* storageNames[] = { "none", "quantized", "full" };
+    for (int s = 0; s < 3; s++)
+    {
+        JumpSessionStore session(storages[s]);
+        double addUsec = MeasureMicroseconds(1, [&]() {
+            session.Clear();
+            for (size_t i = 0; i < frameCount; i++)
+            {
+                session.AddBody(bodies[i], i * FrameDurationUsec);
+            }
+        });
+
+        // The analysis joints and the pelvis heights are exact, the other joints are rounded to whole millimeters
+        float maxError = 0;
+        float maxAnalysisError = 0;
+        int mismatchCount = 0;
+        for (size_t i = 0; i < frameCount; i++)
+        {
+            k4abt_body_t body = session.GetBody(i);
+            for (int joint = 0; joint < static_cast<int>(K4ABT_JOINT_COUNT); joint++)
+            {
+                bool isAnalysisJoint = std::find(AnalysisJointIds.begin(), AnalysisJointIds.end(), joint) != AnalysisJointIds.end();
+                if (!isAnalysisJoint && storages[s] == SkeletonStorage::None)
+                {
+                    continue;
+                }
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    float error = std::abs(body.skeleton.joints[joint].position.v[axis] - bodies[i].skeleton.joints[joint].position.v[axis]);
+                    float& jointMaxError = isAnalysisJoint ? maxAnalysisError : maxError;
+                    jointMaxError = std::max(jointMaxError, error);
+                }
+                if (!isAnalysisJoint && body.skeleton.joints[joint].confidence_level != bodies[i].skeleton.joints[joint].confidence_level)
+                {
+                    mismatchCount++;
+                }
+            }
+            if (body.id != bodies[i].id ||
+                session.GetPelvisHeights()[i] != -bodies[i].skeleton.joints[K4ABT_JOINT_PELVIS].position.xyz.y ||
+                session.GetTimestampsUsec()[i] != i * FrameDurationUsec)
+            {
+                mismatchCount++;
+            }
+        }
+
+        printf("JumpSessionStore %-9s: %zu bytes per frame (k4abt_body_t %zu), max error %.2f mm, analysis joints %.2f mm, %d mismatches, %.3f us per frame\n",
+            storageNames[s], session.GetMemoryUsage() / frameCount, sizeof(k4abt_body_t), maxError, maxAnalysisError, mismatchCount,
+            addUsec / frameCount);
+        success = success && maxError <= 0.5f && maxAnalysisError == 0 && mismatchCount == 0 && session.GetBodyId() == bodies[0].id;
+    }
+    return success;
+}
+
+template <bool IsMaximum>
+bool RunSlidingExtremumBenchmark(const char* name, const std::vector<float>& signal, size_t windowSize)
+{
+    DSP::SlidingExtremum<IsMaximum> extremum(windowSize);
+    int mismatchCount = 0;
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        IndexValueTuple value = extremum.Update(signal[i]);
+
+        // Search of the whole window, the oldest sample wins the ties
+        size_t first = i + 1 >= windowSize ? i + 1 - windowSize : 0;
+        size_t best = first;
+        for (size_t j = first; j <= i; j++)
+        {
+            if (IsMaximum ? signal[j] > signal[best] : signal[j] < signal[best])
+            {
+                best = j;
+            }
+        }
+        if (value.Index != static_cast<int>(best) || value.Value != signal[best])
+        {
+            mismatchCount++;
+        }
+    }
+
+    extremum.Reset();
+    size_t sampleIndex = 0;
+    double updateUsec = MeasureMicroseconds(static_cast<int>(signal.size()), [&]() {
+        extremum.Update(signal[sampleIndex++]);
+    });
+
+    printf("%s of %zu samples: %d mismatches in %zu samples, %.4f us per sample\n", name, windowSize, mismatchCount, signal.size(), updateUsec);
+    return mismatchCount == 0;
+}
+
+int main()
+{
+    bool success = RunJumpDetectorBenchmark();
+    success = RunSessionStoreBenchmark() && success;
+
+    // Quantized values, so the ties are checked as well
+    std::mt19937 generator(2);
+    std::uniform_int_distribution<int> sample(0, 50);
+    std::vector<float> signal(100000);
+    for (float& value : signal)
+    {
+        value = static_cast<float>(sample(generator));
+    }
+    success = RunSlidingExtremumBenchmark<true>("SlidingMaximum", signal, 16) && success;
+    success = RunSlidingExtremumBenchmark<false>("SlidingMinimum", signal, 16) && success;
+
+    printf(success ? "All checks passed\n" : "Some checks failed\n");
+    return success ? 0 : 1;
+}
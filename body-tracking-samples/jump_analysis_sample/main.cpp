@@ -13,19 +13,22 @@
 #include <Utilities.h>
 #include <Window3dWrapper.h>
 
-#include "JumpEvaluator.h"
+#include "JumpEvaluationManager.h"
 
 void PrintAppUsage()
 {
     printf("\n");
     printf(" Basic Usage:\n\n");
-    printf(" 1. Make sure you place the camera parallel to the floor and there is only one person in the scene.\n");
-    printf(" 2. Raise both of your hands above your head or hit 'space' key to start the jump session.\n");
-    printf(" 3. Perform a jump. Try to land at the same location as the starting point.\n");
+    printf(" 1. Make sure you place the camera parallel to the floor. Every person in the scene is evaluated on their own.\n");
+    printf(" 2. Raise both of your hands above your head to start your jump session, or hit 'space' key to start the\n");
+    printf("    sessions of everyone in the scene. The bodies in a jump session are highlighted.\n");
+    printf(" 3. Perform one or more jumps. Try to land at the same location as the starting point.\n");
+    printf("    The analysis results of every jump are printed out on the command prompt right after it lands.\n");
     printf(" 4. Raise both of your hands above your head or hit 'space' key again to finish the session.\n");
-    printf(" 5. Three 3d windows will pop up to show the moment of your deepest squat, jump peak and a replay of your full jump session.\n");
-    printf("    Your jump analysis results will also be printed out on the command prompt.\n");
-    printf(" 6. Close any of the 3d windows to go back to the idle stage.\n");
+    printf("    A session is dropped when its person leaves the scene for about a second.\n");
+    printf(" 5. Three 3d windows will pop up to show the moment of your deepest squat and jump peak of your last jump,\n");
+    printf("    and a replay of your full jump session. The live tracking keeps running during the review.\n");
+    printf(" 6. Close any of the 3d windows to end the review, the reviews of other sessions are shown next.\n");
     printf("\n");
 }
 
@@ -143,8 +146,9 @@ int main(int argc, char** argv)
     window3d.SetCloseCallback(CloseCallback);
     window3d.SetKeyCallback(ProcessKey);
 
-    // Initialize the jump evaluator
-    JumpEvaluator jumpEvaluator;
+    // Initialize the jump evaluation of all the bodies, and the bodies of a frame reused from frame to frame
+    JumpEvaluationManager jumpEvaluationManager;
+    std::vector<k4abt_body_t> bodies;
 
     while (s_isRunning)
     {
@@ -183,38 +187,33 @@ int main(int argc, char** argv)
             k4a_capture_t originalCapture = k4abt_frame_get_capture(bodyFrame);
 
 #pragma region Jump Analysis
-            // Update jump evaluator status
-            jumpEvaluator.UpdateStatus(s_spaceHit);
+            // Update the status of the jump sessions
+            jumpEvaluationManager.UpdateStatus(s_spaceHit);
             s_spaceHit = false;
 
-            // Add new body tracking result to the jump evaluator
-            const size_t JumpEvaluationBodyIndex = 0; // For simplicity, only run jump evaluation on body 0
-            if (k4abt_frame_get_num_bodies(bodyFrame) > 0)
+            // Add the bodies of the new body tracking result to the jump evaluation, all of them in one pass
+            uint32_t numBodies = k4abt_frame_get_num_bodies(bodyFrame);
+            bodies.resize(numBodies);
+            for (uint32_t i = 0; i < numBodies; i++)
             {
-                k4abt_body_t body;
-                VERIFY(k4abt_frame_get_body_skeleton(bodyFrame, JumpEvaluationBodyIndex, &body.skeleton), "Get skeleton from body frame failed!");
-                body.id = k4abt_frame_get_body_id(bodyFrame, JumpEvaluationBodyIndex);
-
-                uint64_t timestampUsec = k4abt_frame_get_device_timestamp_usec(bodyFrame);
-                jumpEvaluator.UpdateData(body, timestampUsec);
+                VERIFY(k4abt_frame_get_body_skeleton(bodyFrame, i, &bodies[i].skeleton), "Get skeleton from body frame failed!");
+                bodies[i].id = k4abt_frame_get_body_id(bodyFrame, i);
             }
+
+            uint64_t timestampUsec = k4abt_frame_get_device_timestamp_usec(bodyFrame);
+            jumpEvaluationManager.UpdateData(bodies, timestampUsec);
 #pragma endregion
 
             // Visualize point cloud
             k4a_image_t depthImage = k4a_capture_get_depth_image(originalCapture);
             window3d.UpdatePointClouds(depthImage);
 
-            // Visualize the skeleton data
+            // Visualize the skeleton data, the bodies in a jump session are highlighted
             window3d.CleanJointsAndBones();
-            uint32_t numBodies = k4abt_frame_get_num_bodies(bodyFrame);
-            for (uint32_t i = 0; i < numBodies; i++)
+            for (const k4abt_body_t& body : bodies)
             {
-                k4abt_body_t body;
-                VERIFY(k4abt_frame_get_body_skeleton(bodyFrame, i, &body.skeleton), "Get skeleton from body frame failed!");
-                body.id = k4abt_frame_get_body_id(bodyFrame, i);
-
                 Color color = g_bodyColors[body.id % g_bodyColors.size()];
-                color.a = i == JumpEvaluationBodyIndex ? 0.8f : 0.1f;
+                color.a = jumpEvaluationManager.IsCollectingJumpData(body.id) ? 0.8f : 0.3f;
 
                 window3d.AddBody(body, color);
             }
@@ -225,6 +224,9 @@ int main(int argc, char** argv)
         }
 
         window3d.Render();
+
+        // Render a frame of the jump review, if any, between two body tracking results
+        jumpEvaluationManager.RenderReview();
     }
 
     std::cout << "Finished jump analysis processing!" << std::endl;
@@ -0,0 +1,259 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "BatchProcessor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static bool HasExtension(const fs::path& path, const char* extension)
+{
+    string pathExtension = path.extension().string();
+    transform(pathExtension.begin(), pathExtension.end(), pathExtension.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return pathExtension == extension;
+}
+
+bool CollectClipJobs(const string& input, const string& outputDirectory, const string& outputExtension, vector<ClipJob>& jobs)
+{
+    error_code error;
+    vector<fs::path> inputPaths;
+    if (fs::is_directory(input, error))
+    {
+        for (const fs::directory_entry& entry : fs::directory_iterator(input, error))
+        {
+            if (entry.is_regular_file(error) && HasExtension(entry.path(), ".mkv"))
+            {
+                inputPaths.push_back(entry.path());
+            }
+        }
+        sort(inputPaths.begin(), inputPaths.end());
+    }
+    else
+    {
+        ifstream manifest(input);
+        if (!manifest.is_open())
+        {
+            cerr << "Cannot open manifest " << input << endl;
+            return false;
+        }
+
+        // Relative paths of the manifest are relative to the manifest itself
+        fs::path manifestDirectory = fs::path(input).parent_path();
+        string line;
+        while (getline(manifest, line))
+        {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            line.erase(0, line.find_first_not_of(" \t"));
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            fs::path inputPath(line);
+            inputPaths.push_back(inputPath.is_relative() ? manifestDirectory / inputPath : inputPath);
+        }
+    }
+
+    if (error)
+    {
+        cerr << "Cannot list " << input << ": " << error.message() << endl;
+        return false;
+    }
+
+    fs::create_directories(outputDirectory, error);
+    if (error)
+    {
+        cerr << "Cannot create output directory " << outputDirectory << ": " << error.message() << endl;
+        return false;
+    }
+
+    set<fs::path> outputPaths;
+    for (const fs::path& inputPath : inputPaths)
+    {
+        ClipJob job;
+        job.InputPath = inputPath.string();
+        fs::path outputPath = fs::path(outputDirectory) / inputPath.filename().replace_extension(outputExtension);
+        if (!outputPaths.insert(outputPath).second)
+        {
+            cerr << "More than one recording of the batch is written to " << outputPath.string() << endl;
+            return false;
+        }
+        job.OutputPath = outputPath.string();
+
+        // A missing file is not an error here, it fails when the worker opens it
+        uintmax_t size = fs::file_size(inputPath, error);
+        job.SizeBytes = error ? 0 : static_cast<uint64_t>(size);
+        jobs.push_back(move(job));
+    }
+    return true;
+}
+
+WorkStealingQueue::WorkStealingQueue(int workerCount)
+{
+    for (int i = 0; i < workerCount; i++)
+    {
+        m_queues.push_back(make_unique<WorkerQueue>());
+    }
+}
+
+void WorkStealingQueue::Push(int workerIndex, ClipJob job)
+{
+    WorkerQueue& queue = *m_queues[workerIndex];
+    lock_guard<mutex> lock(queue.Mutex);
+    queue.Jobs.push_back(move(job));
+}
+
+bool WorkStealingQueue::Pop(int workerIndex, ClipJob& job)
+{
+    {
+        WorkerQueue& queue = *m_queues[workerIndex];
+        lock_guard<mutex> lock(queue.Mutex);
+        if (!queue.Jobs.empty())
+        {
+            job = move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+            return true;
+        }
+    }
+
+    // No clips are added once the workers are running, so the deques only ever shrink. Keep looking for the fullest
+    // deque until a clip could be stolen or every deque is empty.
+    while (true)
+    {
+        WorkerQueue* victim = nullptr;
+        size_t victimSize = 0;
+        for (auto& queue : m_queues)
+        {
+            lock_guard<mutex> lock(queue->Mutex);
+            if (queue->Jobs.size() > victimSize)
+            {
+                victim = queue.get();
+                victimSize = queue->Jobs.size();
+            }
+        }
+
+        if (victim == nullptr)
+        {
+            return false;
+        }
+
+        lock_guard<mutex> lock(victim->Mutex);
+        if (!victim->Jobs.empty())
+        {
+            job = move(victim->Jobs.back());
+            victim->Jobs.pop_back();
+            return true;
+        }
+    }
+}
+
+BatchProcessor::BatchProcessor(int workerCount, ClipProcessor processClip)
+    : m_workerCount(workerCount < 1 ? 1 : workerCount)
+    , m_processClip(move(processClip))
+{
+}
+
+bool BatchProcessor::Run(vector<ClipJob> jobs, PipelineStats& totalStats)
+{
+    totalStats = PipelineStats();
+    if (jobs.empty())
+    {
+        cerr << "No recordings to process" << endl;
+        return false;
+    }
+
+    // Start with the largest clips and deal them out round-robin, so every worker begins with a long clip and the
+    // short clips at the back of the deques are left for stealing at the end of the batch.
+    stable_sort(jobs.begin(), jobs.end(), [](const ClipJob& a, const ClipJob& b) { return a.SizeBytes > b.SizeBytes; });
+
+    int workerCount = min(m_workerCount, (int)jobs.size());
+    WorkStealingQueue queue(workerCount);
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        queue.Push((int)(i % workerCount), move(jobs[i]));
+    }
+
+    cout << "Processing " << jobs.size() << " recordings with " << workerCount << " workers" << endl;
+
+    m_failedClips.clear();
+    m_totalStats = PipelineStats();
+    vector<WorkerStats> stats(workerCount);
+    vector<thread> workers;
+    auto startTime = chrono::steady_clock::now();
+    for (int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&BatchProcessor::RunWorker, this, i, ref(queue), ref(stats[i]));
+    }
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+    double elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    WorkerStats total;
+    printf("\nWorker  Clips  Failed  Frames  Busy (s)     FPS\n");
+    for (int i = 0; i < workerCount; i++)
+    {
+        const WorkerStats& s = stats[i];
+        printf("%6d %6d %7d %7d %9.1f %7.1f\n", i, s.ClipCount, s.FailedClipCount, s.FrameCount, s.BusySeconds,
+            s.BusySeconds > 0 ? s.FrameCount / s.BusySeconds : 0.0);
+        total.ClipCount += s.ClipCount;
+        total.FailedClipCount += s.FailedClipCount;
+        total.FrameCount += s.FrameCount;
+    }
+    printf("Total %d clips, %d frames in %.1f s (%.1f fps)\n", total.ClipCount, total.FrameCount, elapsedSeconds,
+        elapsedSeconds > 0 ? total.FrameCount / elapsedSeconds : 0.0);
+    fflush(stdout);
+
+    totalStats = m_totalStats;
+    totalStats.ElapsedSeconds = elapsedSeconds;
+
+    for (const string& failedClip : m_failedClips)
+    {
+        cerr << "Failed: " << failedClip << endl;
+    }
+    return total.FailedClipCount == 0;
+}
+
+void BatchProcessor::RunWorker(int workerIndex, WorkStealingQueue& queue, WorkerStats& stats)
+{
+    ClipJob job;
+    while (queue.Pop(workerIndex, job))
+    {
+        auto startTime = chrono::steady_clock::now();
+        PipelineStats clipStats;
+        bool success = m_processClip(job, clipStats);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        int frameCount = clipStats.FrameCount;
+
+        stats.ClipCount++;
+        stats.FrameCount += frameCount;
+        stats.BusySeconds += seconds;
+
+        lock_guard<mutex> lock(m_mutex);
+        m_totalStats.Merge(clipStats);
+        if (success)
+        {
+            printf("[worker %d] %s: %d frames in %.1f s, %.1f MB of color dropped -> %s\n", workerIndex,
+                job.InputPath.c_str(), frameCount, seconds, clipStats.DroppedColorBytes / (1024.0 * 1024.0),
+                job.OutputPath.c_str());
+            fflush(stdout);
+        }
+        else
+        {
+            stats.FailedClipCount++;
+            m_failedClips.push_back(job.InputPath);
+            cerr << "[worker " << workerIndex << "] " << job.InputPath << " failed" << endl;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "PipelineStats.h"
+
+// A single recording of a batch and the file its results are written to
+struct ClipJob
+{
+    std::string InputPath;
+    std::string OutputPath;
+    uint64_t SizeBytes = 0;
+};
+
+// Collects the clips of a batch. input is either a directory, in which case every .mkv file of the directory is
+// processed, or a .txt manifest with one recording path per line. Every clip is written to outputDirectory with
+// the file name of the recording and outputExtension.
+bool CollectClipJobs(const std::string& input, const std::string& outputDirectory, const std::string& outputExtension, std::vector<ClipJob>& jobs);
+
+// Clip queue shared by the batch workers.
+//
+// Every worker owns a deque of clips and takes clips from its front. A worker whose deque is empty steals from the
+// back of the deque with the most remaining clips, so a few long clips do not leave the other workers idle.
+class WorkStealingQueue
+{
+public:
+    explicit WorkStealingQueue(int workerCount);
+
+    void Push(int workerIndex, ClipJob job);
+
+    // Returns false once there is no clip left in any of the deques
+    bool Pop(int workerIndex, ClipJob& job);
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex Mutex;
+        std::deque<ClipJob> Jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+};
+
+// Processes a single clip. Returns false if the clip failed, stats are filled in either way.
+using ClipProcessor = std::function<bool(const ClipJob& job, PipelineStats& stats)>;
+
+// Runs the clips of a batch on a fixed number of worker threads and prints a per-worker summary at the end.
+class BatchProcessor
+{
+public:
+    BatchProcessor(int workerCount, ClipProcessor processClip);
+
+    // Returns true if every clip was processed successfully. totalStats combines the stats of all clips.
+    bool Run(std::vector<ClipJob> jobs, PipelineStats& totalStats);
+
+private:
+    struct WorkerStats
+    {
+        int ClipCount = 0;
+        int FailedClipCount = 0;
+        int FrameCount = 0;
+        double BusySeconds = 0;
+    };
+
+    void RunWorker(int workerIndex, WorkStealingQueue& queue, WorkerStats& stats);
+
+private:
+    int m_workerCount = 1;
+    ClipProcessor m_processClip;
+
+    // Serializes the progress messages and the results of the workers
+    std::mutex m_mutex;
+    std::vector<std::string> m_failedClips;
+    PipelineStats m_totalStats;
+};
@@ -0,0 +1,207 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "BinaryResultWriter.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <BodyTrackingHelpers.h>
+
+using namespace std;
+using namespace SkeletonBinary;
+
+// Buffered frames are written to the file once the buffer grows beyond this size
+const size_t BinaryBufferFlushSize = 1 << 20;
+
+bool BinaryResultWriter::Open(const char* outputPath, const ClipInfo& clipInfo)
+{
+    if (!IsLittleEndianHost())
+    {
+        cerr << "The binary output format is only supported on little-endian hosts" << endl;
+        return false;
+    }
+
+    m_outputFile.open(outputPath, ios::out | ios::binary | ios::trunc);
+    if (!m_outputFile.is_open())
+    {
+        cerr << "Cannot open " << outputPath << " for writing" << endl;
+        return false;
+    }
+
+    m_buffer.clear();
+    m_fileOffset = 0;
+    m_frameOffsets.clear();
+
+    FileHeader header = {};
+    memcpy(header.Magic, FileMagic, sizeof(header.Magic));
+    header.Version = FormatVersion;
+    header.JointCount = K4ABT_JOINT_COUNT;
+    header.BoneCount = static_cast<uint32_t>(g_boneList.size());
+    header.BodyRecordSize = sizeof(BodyRecord);
+    Append(&header, sizeof(header));
+
+    AppendString(clipInfo.SdkVersion);
+    AppendString(clipInfo.SourceFile);
+    for (int i = 0; i < (int)K4ABT_JOINT_COUNT; i++)
+    {
+        AppendString(g_jointNames.find((k4abt_joint_id_t)i)->second);
+    }
+    for (const auto& bone : g_boneList)
+    {
+        uint32_t joints[2] = { static_cast<uint32_t>(bone.first), static_cast<uint32_t>(bone.second) };
+        Append(joints, sizeof(joints));
+    }
+    uint32_t calibrationSize = static_cast<uint32_t>(clipInfo.RawCalibration.size());
+    Append(&calibrationSize, sizeof(calibrationSize));
+    Append(clipInfo.RawCalibration.data(), clipInfo.RawCalibration.size());
+
+    // Pad so that all frame records are aligned, then patch the header size
+    m_buffer.resize((m_buffer.size() + RecordAlignment - 1) / RecordAlignment * RecordAlignment, 0);
+    m_fileOffset = m_buffer.size();
+    uint32_t headerSize = static_cast<uint32_t>(m_buffer.size());
+    memcpy(m_buffer.data() + offsetof(FileHeader, HeaderSize), &headerSize, sizeof(headerSize));
+
+    return FlushBuffer();
+}
+
+bool BinaryResultWriter::WriteFrame(const FrameResult& frame)
+{
+    m_frameOffsets.push_back(m_fileOffset);
+
+    FrameHeader frameHeader = {};
+    frameHeader.TimestampUsec = frame.TimestampUsec;
+    frameHeader.FrameId = frame.FrameId;
+    frameHeader.NumBodies = static_cast<uint32_t>(frame.Bodies.size());
+    frameHeader.Flags = ToFrameFlags(frame.Status);
+    Append(&frameHeader, sizeof(frameHeader));
+
+    for (const k4abt_body_t& body : frame.Bodies)
+    {
+        BodyRecord record = ToBodyRecord(body);
+        Append(&record, sizeof(record));
+    }
+
+    if (m_buffer.size() >= BinaryBufferFlushSize)
+    {
+        return FlushBuffer();
+    }
+    return true;
+}
+
+bool BinaryResultWriter::Close()
+{
+    FileFooter footer = {};
+    footer.IndexOffset = m_fileOffset;
+    footer.FrameCount = m_frameOffsets.size();
+    memcpy(footer.Magic, IndexMagic, sizeof(footer.Magic));
+
+    Append(m_frameOffsets.data(), m_frameOffsets.size() * sizeof(uint64_t));
+    Append(&footer, sizeof(footer));
+
+    bool success = FlushBuffer();
+    m_outputFile.close();
+    return success;
+}
+
+bool BinaryResultWriter::Flush(OutputPosition& position)
+{
+    if (!FlushBuffer())
+    {
+        return false;
+    }
+    m_outputFile.flush();
+
+    position.SizeBytes = m_fileOffset;
+    position.FrameCount = m_frameOffsets.size();
+    return m_outputFile.good();
+}
+
+bool BinaryResultWriter::Reopen(const char* outputPath, const ClipInfo& /*clipInfo*/, const OutputPosition& position)
+{
+    if (!IsLittleEndianHost())
+    {
+        cerr << "The binary output format is only supported on little-endian hosts" << endl;
+        return false;
+    }
+
+    // The frame index is only written by Close(), so rebuild it from the frame records before the checkpoint
+    m_frameOffsets.clear();
+    {
+        ifstream inputFile(outputPath, ios::in | ios::binary);
+        FileHeader header;
+        if (!inputFile.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            memcmp(header.Magic, FileMagic, sizeof(header.Magic)) != 0 ||
+            header.BodyRecordSize != sizeof(BodyRecord))
+        {
+            cerr << "Cannot continue " << outputPath << ", it is not a body tracking binary file" << endl;
+            return false;
+        }
+
+        uint64_t offset = header.HeaderSize;
+        while (offset < position.SizeBytes)
+        {
+            FrameHeader frameHeader;
+            inputFile.seekg(static_cast<streamoff>(offset));
+            if (!inputFile.read(reinterpret_cast<char*>(&frameHeader), sizeof(frameHeader)))
+            {
+                break;
+            }
+            m_frameOffsets.push_back(offset);
+            offset += sizeof(FrameHeader) + (uint64_t)frameHeader.NumBodies * sizeof(BodyRecord);
+        }
+
+        if (offset != position.SizeBytes || m_frameOffsets.size() != position.FrameCount)
+        {
+            cerr << "Cannot continue " << outputPath << ", the frames do not match the checkpoint" << endl;
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::resize_file(outputPath, position.SizeBytes, error);
+    if (error)
+    {
+        cerr << "Cannot truncate " << outputPath << ": " << error.message() << endl;
+        return false;
+    }
+
+    m_outputFile.open(outputPath, ios::out | ios::binary | ios::app);
+    if (!m_outputFile.is_open())
+    {
+        cerr << "Cannot open " << outputPath << " for writing" << endl;
+        return false;
+    }
+
+    m_buffer.clear();
+    m_fileOffset = position.SizeBytes;
+    return true;
+}
+
+void BinaryResultWriter::Append(const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+    m_fileOffset += size;
+}
+
+void BinaryResultWriter::AppendString(const string& value)
+{
+    uint32_t length = static_cast<uint32_t>(value.size());
+    Append(&length, sizeof(length));
+    Append(value.data(), value.size());
+}
+
+bool BinaryResultWriter::FlushBuffer()
+{
+    m_outputFile.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<streamsize>(m_buffer.size()));
+    m_buffer.clear();
+    if (!m_outputFile.good())
+    {
+        cerr << "Failed to write binary output" << endl;
+        return false;
+    }
+    return true;
+}
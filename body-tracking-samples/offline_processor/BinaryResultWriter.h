@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ResultWriter.h"
+#include "SkeletonBinaryFormat.h"
+
+// FrameHeader::Flags of a frame with the given status
+inline uint32_t ToFrameFlags(FrameStatus status)
+{
+    switch (status)
+    {
+    case FrameStatus::CarriedForward:
+        return SkeletonBinary::FrameFlagCarriedForward;
+    case FrameStatus::Empty:
+        return SkeletonBinary::FrameFlagEmpty;
+    default:
+        return 0;
+    }
+}
+
+// Status of a frame with the given FrameHeader::Flags
+inline FrameStatus ToFrameStatus(uint32_t frameFlags)
+{
+    if (frameFlags & SkeletonBinary::FrameFlagCarriedForward)
+    {
+        return FrameStatus::CarriedForward;
+    }
+    if (frameFlags & SkeletonBinary::FrameFlagEmpty)
+    {
+        return FrameStatus::Empty;
+    }
+    return FrameStatus::Tracked;
+}
+
+// Writes the results in the binary format described in SkeletonBinaryFormat.h
+class BinaryResultWriter : public ResultWriter
+{
+public:
+    bool Open(const char* outputPath, const ClipInfo& clipInfo) override;
+    bool WriteFrame(const FrameResult& frame) override;
+    bool Close() override;
+    bool Flush(OutputPosition& position) override;
+    bool Reopen(const char* outputPath, const ClipInfo& clipInfo, const OutputPosition& position) override;
+
+private:
+    void Append(const void* data, size_t size);
+    void AppendString(const std::string& value);
+    bool FlushBuffer();
+
+private:
+    std::ofstream m_outputFile;
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_fileOffset = 0;                  // Offset of the end of m_buffer in the output file
+    std::vector<uint64_t> m_frameOffsets;
+};
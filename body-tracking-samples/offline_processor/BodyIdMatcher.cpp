@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "BodyIdMatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using namespace std;
+
+// Two bodies are the same person if their pelvis is on average closer than this over the common captures
+const double MaxMatchDistanceMm = 250.0;
+
+// Bodies must appear together in at least this many captures to be matched
+const int MinMatchFrameCount = 5;
+
+void BodyIdMatcher::AddFrame(const vector<k4abt_body_t>& referenceBodies, const vector<k4abt_body_t>& candidateBodies)
+{
+    for (const k4abt_body_t& body : referenceBodies)
+    {
+        const k4a_float3_t& pelvis = body.skeleton.joints[K4ABT_JOINT_PELVIS].position;
+        for (const k4abt_body_t& candidateBody : candidateBodies)
+        {
+            const k4a_float3_t& candidatePelvis = candidateBody.skeleton.joints[K4ABT_JOINT_PELVIS].position;
+            double dx = pelvis.xyz.x - candidatePelvis.xyz.x;
+            double dy = pelvis.xyz.y - candidatePelvis.xyz.y;
+            double dz = pelvis.xyz.z - candidatePelvis.xyz.z;
+
+            Match& match = m_matches[{ body.id, candidateBody.id }];
+            match.DistanceSum += sqrt(dx * dx + dy * dy + dz * dz);
+            match.FrameCount++;
+        }
+    }
+}
+
+map<uint32_t, uint32_t> BodyIdMatcher::GetMatches() const
+{
+    // Greedily pair the closest bodies first
+    vector<pair<double, pair<uint32_t, uint32_t>>> candidates;
+    for (const auto& match : m_matches)
+    {
+        double meanDistance = match.second.DistanceSum / match.second.FrameCount;
+        if (match.second.FrameCount >= MinMatchFrameCount && meanDistance < MaxMatchDistanceMm)
+        {
+            candidates.push_back({ meanDistance, match.first });
+        }
+    }
+    sort(candidates.begin(), candidates.end());
+
+    map<uint32_t, uint32_t> idMap;
+    set<uint32_t> usedIds;
+    for (const auto& candidate : candidates)
+    {
+        uint32_t referenceId = candidate.second.first;
+        uint32_t candidateId = candidate.second.second;
+        if (usedIds.find(referenceId) == usedIds.end() && idMap.find(candidateId) == idMap.end())
+        {
+            usedIds.insert(referenceId);
+            idMap[candidateId] = referenceId;
+        }
+    }
+    return idMap;
+}
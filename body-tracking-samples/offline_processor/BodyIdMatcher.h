@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <k4abt.h>
+
+// Matches the body ids of two trackers that tracked the same captures.
+//
+// Every tracker numbers its bodies on its own. Bodies whose pelvis stays close over the common captures are
+// considered the same person.
+class BodyIdMatcher
+{
+public:
+    // Bodies of the same capture from the tracker whose ids are kept and from the tracker whose ids are matched
+    void AddFrame(const std::vector<k4abt_body_t>& referenceBodies, const std::vector<k4abt_body_t>& candidateBodies);
+
+    // Candidate ids mapped to reference ids. Every id is used at most once, unmatched candidates are left out.
+    std::map<uint32_t, uint32_t> GetMatches() const;
+
+    void Clear() { m_matches.clear(); }
+
+private:
+    struct Match
+    {
+        double DistanceSum = 0;
+        int FrameCount = 0;
+    };
+
+    // Pelvis distances of (reference id, candidate id) pairs
+    std::map<std::pair<uint32_t, uint32_t>, Match> m_matches;
+};
@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "Checkpoint.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+
+using namespace std;
+using namespace nlohmann;
+
+string GetCheckpointPath(const string& outputPath)
+{
+    return outputPath + ".checkpoint";
+}
+
+bool SaveCheckpoint(const string& checkpointPath, const Checkpoint& checkpoint)
+{
+    json checkpointJson;
+    checkpointJson["source_file"] = checkpoint.SourceFile;
+    checkpointJson["format"] = checkpoint.Format;
+    checkpointJson["last_timestamp_usec"] = checkpoint.LastTimestampUsec;
+    checkpointJson["next_frame_id"] = checkpoint.NextFrameId;
+    checkpointJson["output_size_bytes"] = checkpoint.Output.SizeBytes;
+    checkpointJson["output_frame_count"] = checkpoint.Output.FrameCount;
+    checkpointJson["next_body_id"] = checkpoint.NextBodyId;
+
+    checkpointJson["recent_frames"] = json::array();
+    for (const FrameResult& frame : checkpoint.RecentFrames)
+    {
+        json frameJson;
+        frameJson["timestamp_usec"] = frame.TimestampUsec;
+        frameJson["bodies"] = json::array();
+        for (const k4abt_body_t& body : frame.Bodies)
+        {
+            const k4a_float3_t& pelvis = body.skeleton.joints[K4ABT_JOINT_PELVIS].position;
+            frameJson["bodies"].push_back({ { "body_id", body.id }, { "pelvis", { pelvis.xyz.x, pelvis.xyz.y, pelvis.xyz.z } } });
+        }
+        checkpointJson["recent_frames"].push_back(frameJson);
+    }
+
+    string temporaryPath = checkpointPath + ".tmp";
+    {
+        ofstream checkpointFile(temporaryPath, ios::out | ios::trunc);
+        checkpointFile << setw(4) << checkpointJson << endl;
+        if (!checkpointFile.good())
+        {
+            cerr << "Failed to write checkpoint " << temporaryPath << endl;
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::rename(temporaryPath, checkpointPath, error);
+    if (error)
+    {
+        cerr << "Failed to write checkpoint " << checkpointPath << ": " << error.message() << endl;
+        return false;
+    }
+    return true;
+}
+
+bool LoadCheckpoint(const string& checkpointPath, Checkpoint& checkpoint)
+{
+    ifstream checkpointFile(checkpointPath);
+    if (!checkpointFile.is_open())
+    {
+        return false;
+    }
+
+    json checkpointJson = json::parse(checkpointFile, nullptr, false);
+    if (checkpointJson.is_discarded())
+    {
+        cerr << "Cannot parse checkpoint " << checkpointPath << endl;
+        return false;
+    }
+
+    try
+    {
+        checkpoint.SourceFile = checkpointJson.at("source_file").get<string>();
+        checkpoint.Format = checkpointJson.at("format").get<string>();
+        checkpoint.LastTimestampUsec = checkpointJson.at("last_timestamp_usec").get<uint64_t>();
+        checkpoint.NextFrameId = checkpointJson.at("next_frame_id").get<int>();
+        checkpoint.Output.SizeBytes = checkpointJson.at("output_size_bytes").get<uint64_t>();
+        checkpoint.Output.FrameCount = checkpointJson.at("output_frame_count").get<uint64_t>();
+        checkpoint.NextBodyId = checkpointJson.at("next_body_id").get<uint32_t>();
+
+        checkpoint.RecentFrames.clear();
+        for (const json& frameJson : checkpointJson.at("recent_frames"))
+        {
+            FrameResult frame;
+            frame.TimestampUsec = frameJson.at("timestamp_usec").get<uint64_t>();
+            frame.FrameId = -1;
+            for (const json& bodyJson : frameJson.at("bodies"))
+            {
+                k4abt_body_t body = {};
+                body.id = bodyJson.at("body_id").get<uint32_t>();
+                for (int i = 0; i < 3; i++)
+                {
+                    body.skeleton.joints[K4ABT_JOINT_PELVIS].position.v[i] = bodyJson.at("pelvis").at(i).get<float>();
+                }
+                frame.Bodies.push_back(body);
+            }
+            checkpoint.RecentFrames.push_back(move(frame));
+        }
+    }
+    catch (const json::exception& e)
+    {
+        cerr << "Invalid checkpoint " << checkpointPath << ": " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ResultWriter.h"
+
+// Progress of an interrupted run, stored next to the output file as <output file>.checkpoint
+struct Checkpoint
+{
+    std::string SourceFile;
+    std::string Format;
+
+    // Device timestamp of the last frame that is complete in the output file
+    uint64_t LastTimestampUsec = 0;
+
+    // Frame id of the first capture after LastTimestampUsec
+    int NextFrameId = 0;
+
+    OutputPosition Output;
+
+    // Last frames of the output to match the body ids of the resumed tracker, only the pelvis joint is stored
+    std::vector<FrameResult> RecentFrames;
+    uint32_t NextBodyId = 1;
+};
+
+std::string GetCheckpointPath(const std::string& outputPath);
+
+// The checkpoint is written to a temporary file first and then renamed, so an interruption while saving keeps the
+// previous checkpoint.
+bool SaveCheckpoint(const std::string& checkpointPath, const Checkpoint& checkpoint);
+
+bool LoadCheckpoint(const std::string& checkpointPath, Checkpoint& checkpoint);
@@ -0,0 +1,354 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "JsonResultWriter.h"
+
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#include <BodyTrackingHelpers.h>
+
+using namespace std;
+using namespace nlohmann;
+
+// Indentation used when serializing the json output
+const int JsonIndent = 4;
+
+// Buffered frames are written to the file once the buffer grows beyond this size
+const size_t StreamBufferFlushSize = 1 << 20;
+
+json CreateJsonDocument(const ClipInfo& clipInfo)
+{
+    json jsonOutput;
+    jsonOutput["k4abt_sdk_version"] = clipInfo.SdkVersion;
+    jsonOutput["source_file"] = clipInfo.SourceFile;
+
+    // Store all joint names to the json
+    jsonOutput["joint_names"] = json::array();
+    for (int i = 0; i < (int)K4ABT_JOINT_COUNT; i++)
+    {
+        jsonOutput["joint_names"].push_back(g_jointNames.find((k4abt_joint_id_t)i)->second);
+    }
+
+    // Store all bone linkings to the json
+    jsonOutput["bone_list"] = json::array();
+    for (int i = 0; i < (int)g_boneList.size(); i++)
+    {
+        jsonOutput["bone_list"].push_back({ g_jointNames.find(g_boneList[i].first)->second,
+                                            g_jointNames.find(g_boneList[i].second)->second });
+    }
+
+    return jsonOutput;
+}
+
+// Value of the "gate_status" key, which is only written for frames that were skipped by the motion gate
+const char* GetGateStatusName(FrameStatus status)
+{
+    return status == FrameStatus::CarriedForward ? "carried_forward" : "empty";
+}
+
+/******************************************************************************************************/
+/**************************************** JsonDomResultWriter *****************************************/
+/******************************************************************************************************/
+
+bool JsonDomResultWriter::Open(const char* outputPath, const ClipInfo& clipInfo)
+{
+    m_outputPath = outputPath;
+    m_jsonOutput = CreateJsonDocument(clipInfo);
+    m_framesJson = json::array();
+    return true;
+}
+
+bool JsonDomResultWriter::WriteFrame(const FrameResult& frame)
+{
+    json frameResultJson;
+    frameResultJson["timestamp_usec"] = frame.TimestampUsec;
+    frameResultJson["frame_id"] = frame.FrameId;
+    frameResultJson["num_bodies"] = static_cast<uint32_t>(frame.Bodies.size());
+    if (frame.Status != FrameStatus::Tracked)
+    {
+        frameResultJson["gate_status"] = GetGateStatusName(frame.Status);
+    }
+    frameResultJson["bodies"] = json::array();
+    for (const k4abt_body_t& body : frame.Bodies)
+    {
+        json bodyResultJson;
+        bodyResultJson["body_id"] = static_cast<int>(body.id);
+
+        for (int j = 0; j < (int)K4ABT_JOINT_COUNT; j++)
+        {
+            const k4abt_joint_t& joint = body.skeleton.joints[j];
+            bodyResultJson["joint_positions"].push_back({ joint.position.xyz.x,
+                                                          joint.position.xyz.y,
+                                                          joint.position.xyz.z });
+
+            bodyResultJson["joint_orientations"].push_back({ joint.orientation.wxyz.w,
+                                                             joint.orientation.wxyz.x,
+                                                             joint.orientation.wxyz.y,
+                                                             joint.orientation.wxyz.z });
+        }
+        frameResultJson["bodies"].push_back(bodyResultJson);
+    }
+    m_framesJson.push_back(frameResultJson);
+    return true;
+}
+
+bool JsonDomResultWriter::Close()
+{
+    m_jsonOutput["frames"] = std::move(m_framesJson);
+
+    std::ofstream outputFile(m_outputPath);
+    outputFile << std::setw(JsonIndent) << m_jsonOutput << std::endl;
+    if (!outputFile.good())
+    {
+        cerr << "Failed to write " << m_outputPath << endl;
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************************************/
+/*************************************** JsonStreamResultWriter ***************************************/
+/******************************************************************************************************/
+
+bool JsonStreamResultWriter::Open(const char* outputPath, const ClipInfo& clipInfo)
+{
+    m_outputFile.open(outputPath, ios::out | ios::binary | ios::trunc);
+    if (!m_outputFile.is_open())
+    {
+        cerr << "Cannot open " << outputPath << " for writing" << endl;
+        return false;
+    }
+
+    m_fileSize = 0;
+    m_frameCount = 0;
+    return SplitDocument(clipInfo, m_buffer) && FlushBuffer();
+}
+
+bool JsonStreamResultWriter::Reopen(const char* outputPath, const ClipInfo& clipInfo, const OutputPosition& position)
+{
+    string jsonHead;
+    if (!SplitDocument(clipInfo, jsonHead))
+    {
+        return false;
+    }
+
+    error_code error;
+    uintmax_t fileSize = filesystem::file_size(outputPath, error);
+    if (error || fileSize < position.SizeBytes || position.SizeBytes < jsonHead.size())
+    {
+        cerr << outputPath << " is shorter than its checkpoint" << endl;
+        return false;
+    }
+
+    filesystem::resize_file(outputPath, position.SizeBytes, error);
+    if (error)
+    {
+        cerr << "Cannot truncate " << outputPath << ": " << error.message() << endl;
+        return false;
+    }
+
+    m_outputFile.open(outputPath, ios::out | ios::binary | ios::app);
+    if (!m_outputFile.is_open())
+    {
+        cerr << "Cannot open " << outputPath << " for writing" << endl;
+        return false;
+    }
+
+    m_buffer.clear();
+    m_fileSize = position.SizeBytes;
+    m_frameCount = position.FrameCount;
+    return true;
+}
+
+bool JsonStreamResultWriter::SplitDocument(const ClipInfo& clipInfo, string& jsonHead)
+{
+    // Serialize the document without any frame and split it where the frames go. This keeps everything except
+    // the frames exactly as nlohmann::json formats it.
+    json jsonOutput = CreateJsonDocument(clipInfo);
+    jsonOutput["frames"] = json::array();
+    string document = jsonOutput.dump(JsonIndent) + "\n";
+
+    const string framesKey = "\n" + string(JsonIndent, ' ') + "\"frames\": [";
+    size_t framesStart = document.find(framesKey);
+    if (framesStart == string::npos)
+    {
+        cerr << "Unexpected json document layout" << endl;
+        return false;
+    }
+    size_t framesEnd = framesStart + framesKey.size();
+
+    jsonHead.assign(document, 0, framesEnd);
+    m_jsonTail.assign(document, framesEnd, string::npos);
+    return true;
+}
+
+bool JsonStreamResultWriter::WriteFrame(const FrameResult& frame)
+{
+    // Frames are elements of the "frames" array at the second level of the document
+    const int frameIndent = 2 * JsonIndent;
+    const int bodyIndent = 4 * JsonIndent;
+
+    m_buffer += m_frameCount == 0 ? "\n" : ",\n";
+    AppendIndent(frameIndent);
+    m_buffer += "{\n";
+
+    AppendIndent(frameIndent + JsonIndent);
+    m_buffer += "\"bodies\": ";
+    if (frame.Bodies.empty())
+    {
+        m_buffer += "[]";
+    }
+    else
+    {
+        m_buffer += "[\n";
+        for (size_t i = 0; i < frame.Bodies.size(); i++)
+        {
+            const k4abt_body_t& body = frame.Bodies[i];
+
+            AppendIndent(bodyIndent);
+            m_buffer += "{\n";
+            AppendIndent(bodyIndent + JsonIndent);
+            m_buffer += "\"body_id\": ";
+            m_buffer += to_string(static_cast<int>(body.id));
+            m_buffer += ",\n";
+
+            AppendIndent(bodyIndent + JsonIndent);
+            m_buffer += "\"joint_orientations\": [\n";
+            for (int j = 0; j < (int)K4ABT_JOINT_COUNT; j++)
+            {
+                AppendFloatArray(body.skeleton.joints[j].orientation.v, 4, bodyIndent + 2 * JsonIndent);
+                m_buffer += j + 1 < (int)K4ABT_JOINT_COUNT ? ",\n" : "\n";
+            }
+            AppendIndent(bodyIndent + JsonIndent);
+            m_buffer += "],\n";
+
+            AppendIndent(bodyIndent + JsonIndent);
+            m_buffer += "\"joint_positions\": [\n";
+            for (int j = 0; j < (int)K4ABT_JOINT_COUNT; j++)
+            {
+                AppendFloatArray(body.skeleton.joints[j].position.v, 3, bodyIndent + 2 * JsonIndent);
+                m_buffer += j + 1 < (int)K4ABT_JOINT_COUNT ? ",\n" : "\n";
+            }
+            AppendIndent(bodyIndent + JsonIndent);
+            m_buffer += "]\n";
+
+            AppendIndent(bodyIndent);
+            m_buffer += i + 1 < frame.Bodies.size() ? "},\n" : "}\n";
+        }
+        AppendIndent(frameIndent + JsonIndent);
+        m_buffer += "]";
+    }
+    m_buffer += ",\n";
+
+    AppendIndent(frameIndent + JsonIndent);
+    m_buffer += "\"frame_id\": ";
+    m_buffer += to_string(frame.FrameId);
+    m_buffer += ",\n";
+
+    if (frame.Status != FrameStatus::Tracked)
+    {
+        AppendIndent(frameIndent + JsonIndent);
+        m_buffer += "\"gate_status\": \"";
+        m_buffer += GetGateStatusName(frame.Status);
+        m_buffer += "\",\n";
+    }
+
+    AppendIndent(frameIndent + JsonIndent);
+    m_buffer += "\"num_bodies\": ";
+    m_buffer += to_string(frame.Bodies.size());
+    m_buffer += ",\n";
+
+    AppendIndent(frameIndent + JsonIndent);
+    m_buffer += "\"timestamp_usec\": ";
+    m_buffer += to_string(frame.TimestampUsec);
+    m_buffer += "\n";
+
+    AppendIndent(frameIndent);
+    m_buffer += "}";
+
+    m_frameCount++;
+
+    if (m_buffer.size() >= StreamBufferFlushSize)
+    {
+        return FlushBuffer();
+    }
+    return true;
+}
+
+bool JsonStreamResultWriter::Close()
+{
+    if (m_frameCount > 0)
+    {
+        m_buffer += "\n";
+        AppendIndent(JsonIndent);
+    }
+    m_buffer += m_jsonTail;
+
+    bool success = FlushBuffer();
+    m_outputFile.close();
+    return success;
+}
+
+bool JsonStreamResultWriter::Flush(OutputPosition& position)
+{
+    if (!FlushBuffer())
+    {
+        return false;
+    }
+    m_outputFile.flush();
+
+    position.SizeBytes = m_fileSize;
+    position.FrameCount = m_frameCount;
+    return m_outputFile.good();
+}
+
+void JsonStreamResultWriter::AppendIndent(int indent)
+{
+    m_buffer.append(static_cast<size_t>(indent), ' ');
+}
+
+void JsonStreamResultWriter::AppendFloat(float value)
+{
+    // nlohmann::json stores numbers as double and writes non-finite values as null
+    double number = static_cast<double>(value);
+    if (!std::isfinite(number))
+    {
+        m_buffer += "null";
+        return;
+    }
+
+    // Use the same shortest round-trip formatting as nlohmann::json::dump() to stay byte-compatible
+    char numberBuffer[64];
+    char* end = nlohmann::detail::to_chars(numberBuffer, numberBuffer + sizeof(numberBuffer), number);
+    m_buffer.append(numberBuffer, end);
+}
+
+void JsonStreamResultWriter::AppendFloatArray(const float* values, int count, int indent)
+{
+    AppendIndent(indent);
+    m_buffer += "[\n";
+    for (int i = 0; i < count; i++)
+    {
+        AppendIndent(indent + JsonIndent);
+        AppendFloat(values[i]);
+        m_buffer += i + 1 < count ? ",\n" : "\n";
+    }
+    AppendIndent(indent);
+    m_buffer += "]";
+}
+
+bool JsonStreamResultWriter::FlushBuffer()
+{
+    m_outputFile.write(m_buffer.data(), static_cast<streamsize>(m_buffer.size()));
+    m_fileSize += m_buffer.size();
+    m_buffer.clear();
+    if (!m_outputFile.good())
+    {
+        cerr << "Failed to write json output" << endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "ResultWriter.h"
+
+// Builds the whole json document in memory and writes it out on Close().
+class JsonDomResultWriter : public ResultWriter
+{
+public:
+    bool Open(const char* outputPath, const ClipInfo& clipInfo) override;
+    bool WriteFrame(const FrameResult& frame) override;
+    bool Close() override;
+
+private:
+    std::string m_outputPath;
+    nlohmann::json m_jsonOutput;
+    nlohmann::json m_framesJson;
+};
+
+// Writes each frame to disk as soon as it is available. Memory usage does not depend on the clip length and the
+// output is byte-identical to the one of JsonDomResultWriter.
+class JsonStreamResultWriter : public ResultWriter
+{
+public:
+    bool Open(const char* outputPath, const ClipInfo& clipInfo) override;
+    bool WriteFrame(const FrameResult& frame) override;
+    bool Close() override;
+    bool Flush(OutputPosition& position) override;
+    bool Reopen(const char* outputPath, const ClipInfo& clipInfo, const OutputPosition& position) override;
+
+private:
+    bool SplitDocument(const ClipInfo& clipInfo, std::string& jsonHead);
+    void AppendIndent(int indent);
+    void AppendFloat(float value);
+    void AppendFloatArray(const float* values, int count, int indent);
+    bool FlushBuffer();
+
+private:
+    std::ofstream m_outputFile;
+    std::string m_buffer;
+    std::string m_jsonTail;
+    size_t m_frameCount = 0;
+    uint64_t m_fileSize = 0;
+};
@@ -0,0 +1,187 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "MkvResultWriter.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <BodyTrackingHelpers.h>
+
+#include "BinaryResultWriter.h"
+#include "MkvTrackFormat.h"
+
+using namespace std;
+using namespace SkeletonBinary;
+using namespace SkeletonMkv;
+
+// Name of the calibration attachment that k4a_playback_get_calibration() reads
+const char CalibrationAttachmentName[] = "calibration.json";
+
+void GetDepthResolution(k4a_depth_mode_t depthMode, uint64_t& width, uint64_t& height)
+{
+    switch (depthMode)
+    {
+    case K4A_DEPTH_MODE_NFOV_2X2BINNED:
+        width = 320;
+        height = 288;
+        break;
+    case K4A_DEPTH_MODE_NFOV_UNBINNED:
+        width = 640;
+        height = 576;
+        break;
+    case K4A_DEPTH_MODE_WFOV_2X2BINNED:
+        width = 512;
+        height = 512;
+        break;
+    default:
+        width = 1024;
+        height = 1024;
+        break;
+    }
+}
+
+uint64_t GetFrameRate(k4a_fps_t fps)
+{
+    switch (fps)
+    {
+    case K4A_FRAMES_PER_SECOND_5:
+        return 5;
+    case K4A_FRAMES_PER_SECOND_15:
+        return 15;
+    default:
+        return 30;
+    }
+}
+
+MkvResultWriter::MkvResultWriter(const k4a_record_configuration_t& recordConfiguration)
+    : m_recordConfiguration(recordConfiguration)
+{
+}
+
+MkvResultWriter::~MkvResultWriter()
+{
+    if (m_recording != nullptr)
+    {
+        k4a_record_close(m_recording);
+    }
+}
+
+bool MkvResultWriter::Open(const char* outputPath, const ClipInfo& clipInfo)
+{
+    // Only the depth and IR tracks are copied, the color images are not kept by the offline processor
+    k4a_device_configuration_t deviceConfig = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    deviceConfig.depth_mode = m_recordConfiguration.depth_mode;
+    deviceConfig.camera_fps = m_recordConfiguration.camera_fps;
+    deviceConfig.wired_sync_mode = m_recordConfiguration.wired_sync_mode;
+    deviceConfig.depth_delay_off_color_usec = m_recordConfiguration.depth_delay_off_color_usec;
+    deviceConfig.subordinate_delay_off_master_usec = m_recordConfiguration.subordinate_delay_off_master_usec;
+
+    // There is no device to take the calibration from, it is added as an attachment below
+    if (K4A_RESULT_SUCCEEDED != k4a_record_create(outputPath, nullptr, deviceConfig, &m_recording))
+    {
+        cerr << "Cannot create recording " << outputPath << endl;
+        m_recording = nullptr;
+        return false;
+    }
+
+    if (!AddTracks(clipInfo) || K4A_RESULT_SUCCEEDED != k4a_record_write_header(m_recording))
+    {
+        cerr << "Failed to write the header of " << outputPath << endl;
+        k4a_record_close(m_recording);
+        m_recording = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool MkvResultWriter::AddTracks(const ClipInfo& clipInfo)
+{
+    if (!clipInfo.RawCalibration.empty())
+    {
+        // The raw calibration is a zero terminated json string, the terminator is not part of the attachment
+        size_t calibrationSize = strnlen(reinterpret_cast<const char*>(clipInfo.RawCalibration.data()), clipInfo.RawCalibration.size());
+        if (K4A_RESULT_SUCCEEDED != k4a_record_add_attachment(m_recording, CalibrationAttachmentName, clipInfo.RawCalibration.data(), calibrationSize) ||
+            K4A_RESULT_SUCCEEDED != k4a_record_add_tag(m_recording, "K4A_CALIBRATION_FILE", CalibrationAttachmentName))
+        {
+            return false;
+        }
+    }
+
+    if (K4A_RESULT_SUCCEEDED != k4a_record_add_tag(m_recording, "K4ABT_SDK_VERSION", clipInfo.SdkVersion.c_str()) ||
+        K4A_RESULT_SUCCEEDED != k4a_record_add_tag(m_recording, "K4ABT_SOURCE_FILE", clipInfo.SourceFile.c_str()))
+    {
+        return false;
+    }
+
+    FileHeader header = {};
+    memcpy(header.Magic, FileMagic, sizeof(header.Magic));
+    header.Version = FormatVersion;
+    header.HeaderSize = sizeof(FileHeader);
+    header.JointCount = K4ABT_JOINT_COUNT;
+    header.BoneCount = static_cast<uint32_t>(g_boneList.size());
+    header.BodyRecordSize = sizeof(BodyRecord);
+
+    k4a_record_subtitle_settings_t subtitleSettings = {};
+    subtitleSettings.high_freq_data = false;
+    if (K4A_RESULT_SUCCEEDED != k4a_record_add_custom_subtitle_track(m_recording, SkeletonTrackName, SkeletonCodecId,
+        reinterpret_cast<const uint8_t*>(&header), sizeof(header), &subtitleSettings))
+    {
+        return false;
+    }
+
+    k4a_record_video_settings_t videoSettings = {};
+    GetDepthResolution(m_recordConfiguration.depth_mode, videoSettings.width, videoSettings.height);
+    videoSettings.frame_rate = GetFrameRate(m_recordConfiguration.camera_fps);
+    return K4A_RESULT_SUCCEEDED == k4a_record_add_custom_video_track(m_recording, BodyIndexTrackName, BodyIndexCodecId,
+        nullptr, 0, &videoSettings);
+}
+
+bool MkvResultWriter::WriteFrame(const FrameResult& frame)
+{
+    // The images go first so the results are stored next to them in the same cluster
+    if (frame.Capture != nullptr && K4A_RESULT_SUCCEEDED != k4a_record_write_capture(m_recording, frame.Capture))
+    {
+        cerr << "Failed to write the capture of frame " << frame.FrameId << endl;
+        return false;
+    }
+
+    FrameHeader frameHeader = {};
+    frameHeader.TimestampUsec = frame.TimestampUsec;
+    frameHeader.FrameId = frame.FrameId;
+    frameHeader.NumBodies = static_cast<uint32_t>(frame.Bodies.size());
+    frameHeader.Flags = ToFrameFlags(frame.Status);
+
+    m_buffer.resize(sizeof(FrameHeader) + frame.Bodies.size() * sizeof(BodyRecord));
+    memcpy(m_buffer.data(), &frameHeader, sizeof(FrameHeader));
+    for (size_t i = 0; i < frame.Bodies.size(); i++)
+    {
+        BodyRecord record = ToBodyRecord(frame.Bodies[i]);
+        memcpy(m_buffer.data() + sizeof(FrameHeader) + i * sizeof(BodyRecord), &record, sizeof(BodyRecord));
+    }
+    if (K4A_RESULT_SUCCEEDED != k4a_record_write_custom_track_data(m_recording, SkeletonTrackName, frame.TimestampUsec, m_buffer.data(), m_buffer.size()))
+    {
+        cerr << "Failed to write the skeletons of frame " << frame.FrameId << endl;
+        return false;
+    }
+
+    if (frame.BodyIndexMap != nullptr)
+    {
+        EncodeBodyIndexMap(k4a_image_get_buffer(frame.BodyIndexMap), k4a_image_get_width_pixels(frame.BodyIndexMap),
+            k4a_image_get_height_pixels(frame.BodyIndexMap), k4a_image_get_stride_bytes(frame.BodyIndexMap), m_buffer);
+        if (K4A_RESULT_SUCCEEDED != k4a_record_write_custom_track_data(m_recording, BodyIndexTrackName, frame.TimestampUsec, m_buffer.data(), m_buffer.size()))
+        {
+            cerr << "Failed to write the body index map of frame " << frame.FrameId << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MkvResultWriter::Close()
+{
+    bool success = K4A_RESULT_SUCCEEDED == k4a_record_flush(m_recording);
+    k4a_record_close(m_recording);
+    m_recording = nullptr;
+    return success;
+}
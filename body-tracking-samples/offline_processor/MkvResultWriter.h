@@ -0,0 +1,34 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <k4arecord/record.h>
+
+#include "ResultWriter.h"
+
+// Writes a new recording with the depth and IR images of the processed captures and the results on the custom tracks
+// described in MkvTrackFormat.h
+class MkvResultWriter : public ResultWriter
+{
+public:
+    // recordConfiguration is the configuration of the input recording
+    explicit MkvResultWriter(const k4a_record_configuration_t& recordConfiguration);
+    ~MkvResultWriter() override;
+
+    bool Open(const char* outputPath, const ClipInfo& clipInfo) override;
+    bool WriteFrame(const FrameResult& frame) override;
+    bool Close() override;
+    bool WritesCaptures() const override { return true; }
+
+private:
+    bool AddTracks(const ClipInfo& clipInfo);
+
+private:
+    k4a_record_configuration_t m_recordConfiguration;
+    k4a_record_t m_recording = nullptr;
+    std::vector<uint8_t> m_buffer;
+};
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SkeletonBinaryFormat.h"
+
+// Custom tracks of the recording written by the offline processor ("-format mkv").
+//
+// The recording holds the depth and IR tracks of the input recording and its calibration. Every capture that went
+// through the offline processor has a block with the device timestamp of the capture on the custom tracks below, so a
+// playback reads the results together with the images through k4a_playback_get_next_data_block():
+//
+//   BODY_SKELETON: subtitle track with codec id S_K4ABT/SKELETON
+//       Codec context: SkeletonBinary::FileHeader with HeaderSize set to sizeof(FileHeader)
+//       Block: SkeletonBinary::FrameHeader followed by FrameHeader::NumBodies BodyRecord entries, the same layout as a
+//              frame record of the binary format
+//
+//   BODY_INDEX_MAP: video track with codec id V_K4ABT/BODY_INDEX_RLE and the resolution of the depth image
+//       Block: body index map of the capture, run-length encoded as described at EncodeBodyIndexMap(). Captures that
+//              were skipped by the motion gate have no body index map.
+namespace SkeletonMkv
+{
+    const char SkeletonTrackName[] = "BODY_SKELETON";
+    const char SkeletonCodecId[] = "S_K4ABT/SKELETON";
+
+    const char BodyIndexTrackName[] = "BODY_INDEX_MAP";
+    const char BodyIndexCodecId[] = "V_K4ABT/BODY_INDEX_RLE";
+
+    // Row-major pixels are stored as runs of equal values. Every run is the pixel value followed by the run length as
+    // an unsigned LEB128 varint. Most of a body index map is K4ABT_BODY_INDEX_MAP_BACKGROUND, so a map usually
+    // compresses to a few kilobytes.
+    inline void EncodeBodyIndexMap(const uint8_t* pixels, int width, int height, int stride, std::vector<uint8_t>& encoded)
+    {
+        encoded.clear();
+        uint8_t runValue = 0;
+        uint32_t runLength = 0;
+        auto appendRun = [&]() {
+            encoded.push_back(runValue);
+            for (uint32_t length = runLength; ; length >>= 7)
+            {
+                if (length < 0x80)
+                {
+                    encoded.push_back((uint8_t)length);
+                    break;
+                }
+                encoded.push_back((uint8_t)(length & 0x7F) | 0x80);
+            }
+        };
+
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t* row = pixels + (size_t)y * stride;
+            for (int x = 0; x < width; x++)
+            {
+                if (runLength > 0 && row[x] == runValue)
+                {
+                    runLength++;
+                    continue;
+                }
+                if (runLength > 0)
+                {
+                    appendRun();
+                }
+                runValue = row[x];
+                runLength = 1;
+            }
+        }
+        if (runLength > 0)
+        {
+            appendRun();
+        }
+    }
+
+    // Returns false if the runs do not add up to exactly pixelCount pixels
+    inline bool DecodeBodyIndexMap(const uint8_t* encoded, size_t encodedSize, uint8_t* pixels, size_t pixelCount)
+    {
+        size_t pixelIndex = 0;
+        size_t offset = 0;
+        while (offset < encodedSize)
+        {
+            uint8_t value = encoded[offset++];
+            uint64_t runLength = 0;
+            for (int shift = 0; ; shift += 7)
+            {
+                if (offset == encodedSize || shift > 28)
+                {
+                    return false;
+                }
+                uint8_t byte = encoded[offset++];
+                runLength |= (uint64_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    break;
+                }
+            }
+
+            if (runLength > pixelCount - pixelIndex)
+            {
+                return false;
+            }
+            for (uint64_t i = 0; i < runLength; i++)
+            {
+                pixels[pixelIndex++] = value;
+            }
+        }
+        return pixelIndex == pixelCount;
+    }
+}
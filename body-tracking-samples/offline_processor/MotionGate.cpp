@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "MotionGate.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+// Only every GridStep-th pixel of every GridStep-th row is compared, which is plenty to detect a moving person
+const int GridStep = 4;
+
+// The background moves 1 / 2^BackgroundBlendShift of the way towards every new depth image
+const int BackgroundBlendShift = 3;
+
+MotionGate::MotionGate(const MotionGateConfig& config)
+    : m_config(config)
+{
+}
+
+bool MotionGate::ShouldTrack(k4a_image_t depthImage)
+{
+    int width = k4a_image_get_width_pixels(depthImage);
+    int height = k4a_image_get_height_pixels(depthImage);
+    int stride = k4a_image_get_stride_bytes(depthImage);
+    const uint8_t* buffer = k4a_image_get_buffer(depthImage);
+
+    // The first image, or an image of another depth mode, becomes the background
+    bool resetBackground = width != m_width || height != m_height;
+    if (resetBackground)
+    {
+        m_width = width;
+        m_height = height;
+        m_background.assign((size_t)((width + GridStep - 1) / GridStep) * ((height + GridStep - 1) / GridStep), 0);
+    }
+
+    int validCount = 0;
+    int changedCount = 0;
+    uint16_t* background = m_background.data();
+    for (int y = 0; y < height; y += GridStep)
+    {
+        const uint16_t* row = reinterpret_cast<const uint16_t*>(buffer + (size_t)y * stride);
+        for (int x = 0; x < width; x += GridStep, background++)
+        {
+            int depth = row[x];
+            if (depth == 0)
+            {
+                // Invalid pixel, keep the background as is
+                continue;
+            }
+
+            int difference = depth - *background;
+            if (*background == 0)
+            {
+                *background = (uint16_t)depth;
+                continue;
+            }
+
+            validCount++;
+            if (abs(difference) > m_config.DepthThresholdMm)
+            {
+                changedCount++;
+            }
+            *background = (uint16_t)(*background + difference / (1 << BackgroundBlendShift));
+        }
+    }
+
+    bool track = resetBackground || validCount == 0 ||
+        changedCount * 100.0f > m_config.ChangedPixelPercent * validCount ||
+        m_skippedFrames >= m_config.MaxSkippedFrames;
+    m_skippedFrames = track ? 0 : m_skippedFrames + 1;
+    return track;
+}
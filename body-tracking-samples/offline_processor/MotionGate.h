@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <k4a/k4a.h>
+
+// Thresholds of the MotionGate
+struct MotionGateConfig
+{
+    // A depth pixel changed if it differs from the background by more than this
+    uint16_t DepthThresholdMm = 50;
+
+    // A frame is tracked if more than this percentage of the valid depth pixels changed
+    float ChangedPixelPercent = 0.5f;
+
+    // Track a frame after this many skipped frames in a row even if nothing changed
+    int MaxSkippedFrames = 30;
+};
+
+// Decides whether a capture has to go through the body tracker.
+//
+// A background model of the scene is kept for a subsampled grid of depth pixels. A depth image is tracked if enough
+// of its pixels differ from the background, otherwise the tracking result of the last tracked image still holds and
+// the image is skipped. Static scenes slowly blend into the background, so a person that stopped moving is tracked
+// again at least every MaxSkippedFrames frames.
+class MotionGate
+{
+public:
+    explicit MotionGate(const MotionGateConfig& config);
+
+    // Compares depthImage against the background and adds it to the background
+    bool ShouldTrack(k4a_image_t depthImage);
+
+private:
+    MotionGateConfig m_config;
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<uint16_t> m_background;
+    int m_skippedFrames = 0;
+};
@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "PipelineStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+using namespace nlohmann;
+
+/******************************************************************************************************/
+/***************************************** LatencyHistogram *******************************************/
+/******************************************************************************************************/
+
+// Values below 2 * SubBucketCount have a bucket each. Above that every power of two has SubBucketCount buckets, up to
+// the 64th bit.
+LatencyHistogram::LatencyHistogram()
+    : m_counts((64 - SubBucketBits + 1) * SubBucketCount, 0)
+{
+}
+
+int LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+    if (value < 2 * SubBucketCount)
+    {
+        return (int)value;
+    }
+
+    int highestBit = 63;
+    while ((value >> highestBit) == 0)
+    {
+        highestBit--;
+    }
+    int shift = highestBit - SubBucketBits;
+    return shift * SubBucketCount + (int)(value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(int index)
+{
+    if (index < 2 * SubBucketCount)
+    {
+        return (uint64_t)index;
+    }
+
+    int shift = index / SubBucketCount - 1;
+    uint64_t subBucket = (uint64_t)(index % SubBucketCount + SubBucketCount);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t valueUsec)
+{
+    m_counts[GetBucketIndex(valueUsec)]++;
+    m_count++;
+    m_sum += valueUsec;
+    m_max = max(m_max, valueUsec);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+    for (size_t i = 0; i < m_counts.size(); i++)
+    {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_max = max(m_max, other.m_max);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)ceil(min(max(percentile, 0.0), 100.0) / 100.0 * m_count);
+    rank = max<uint64_t>(rank, 1);
+
+    uint64_t cumulativeCount = 0;
+    for (size_t i = 0; i < m_counts.size(); i++)
+    {
+        cumulativeCount += m_counts[i];
+        if (cumulativeCount >= rank)
+        {
+            return min(GetBucketUpperBound((int)i), m_max);
+        }
+    }
+    return m_max;
+}
+
+json LatencyHistogram::ToJson() const
+{
+    json histogramJson;
+    histogramJson["count"] = m_count;
+    histogramJson["mean_usec"] = GetMean();
+    histogramJson["p50_usec"] = GetPercentile(50);
+    histogramJson["p95_usec"] = GetPercentile(95);
+    histogramJson["p99_usec"] = GetPercentile(99);
+    histogramJson["max_usec"] = m_max;
+    histogramJson["total_usec"] = m_sum;
+    return histogramJson;
+}
+
+/******************************************************************************************************/
+/******************************************* PipelineStats ********************************************/
+/******************************************************************************************************/
+
+void PipelineStats::Merge(const PipelineStats& other)
+{
+    FrameCount += other.FrameCount;
+    SkippedFrameCount += other.SkippedFrameCount;
+    Decode.Merge(other.Decode);
+    Enqueue.Merge(other.Enqueue);
+    Pop.Merge(other.Pop);
+    Write.Merge(other.Write);
+    CloseSeconds += other.CloseSeconds;
+    DroppedColorImageCount += other.DroppedColorImageCount;
+    DroppedColorBytes += other.DroppedColorBytes;
+}
+
+void PipelineStats::Print(ostream& output) const
+{
+    char line[256];
+    snprintf(line, sizeof(line), "Processed %d frames in %.2f s (%.1f fps)", FrameCount, ElapsedSeconds,
+        ElapsedSeconds > 0 ? FrameCount / ElapsedSeconds : 0.0);
+    output << line << endl;
+
+    if (SkippedFrameCount > 0)
+    {
+        snprintf(line, sizeof(line), "Motion gate skipped %d frames (%.1f%%)", SkippedFrameCount,
+            FrameCount > 0 ? 100.0 * SkippedFrameCount / FrameCount : 0.0);
+        output << line << endl;
+    }
+
+    output << "Stage       Count   Mean (ms)    p50 (ms)    p95 (ms)    p99 (ms)    Max (ms)   Total (s)" << endl;
+    const pair<const char*, const LatencyHistogram*> stages[] = {
+        { "decode", &Decode }, { "enqueue", &Enqueue }, { "pop", &Pop }, { "write", &Write } };
+    for (const auto& stage : stages)
+    {
+        const LatencyHistogram& histogram = *stage.second;
+        snprintf(line, sizeof(line), "%-8s %8llu %11.3f %11.3f %11.3f %11.3f %11.3f %11.2f", stage.first,
+            (unsigned long long)histogram.GetCount(), histogram.GetMean() / 1000.0,
+            histogram.GetPercentile(50) / 1000.0, histogram.GetPercentile(95) / 1000.0,
+            histogram.GetPercentile(99) / 1000.0, histogram.GetMax() / 1000.0,
+            histogram.GetMean() * histogram.GetCount() / 1e6);
+        output << line << endl;
+    }
+
+    snprintf(line, sizeof(line), "Closing the output files took %.2f s", CloseSeconds);
+    output << line << endl;
+
+    if (DroppedColorImageCount > 0)
+    {
+        snprintf(line, sizeof(line), "Dropped %llu color images (%.1f MB) that are not used by the tracker",
+            (unsigned long long)DroppedColorImageCount, DroppedColorBytes / (1024.0 * 1024.0));
+        output << line << endl;
+    }
+}
+
+json PipelineStats::ToJson() const
+{
+    json statsJson;
+    statsJson["frames"] = FrameCount;
+    statsJson["elapsed_seconds"] = ElapsedSeconds;
+    statsJson["fps"] = ElapsedSeconds > 0 ? FrameCount / ElapsedSeconds : 0.0;
+    statsJson["skipped_frames"] = SkippedFrameCount;
+    statsJson["close_seconds"] = CloseSeconds;
+    statsJson["dropped_color_images"] = DroppedColorImageCount;
+    statsJson["dropped_color_bytes"] = DroppedColorBytes;
+    statsJson["stages"]["decode"] = Decode.ToJson();
+    statsJson["stages"]["enqueue"] = Enqueue.ToJson();
+    statsJson["stages"]["pop"] = Pop.ToJson();
+    statsJson["stages"]["write"] = Write.ToJson();
+    return statsJson;
+}
@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Histogram of latencies in microseconds with a fixed relative precision.
+//
+// Values are counted in log-linear buckets like an HDR histogram: every power of two range is split into
+// SubBucketCount linear buckets, so percentiles are accurate to about 3% over the whole range of uint64_t with a
+// fixed amount of memory. Recording a value is O(1) and never allocates.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void Record(uint64_t valueUsec);
+    void Merge(const LatencyHistogram& other);
+
+    uint64_t GetCount() const { return m_count; }
+    uint64_t GetMax() const { return m_max; }
+    double GetMean() const { return m_count == 0 ? 0.0 : (double)m_sum / m_count; }
+
+    // Highest value that is equivalent to the value at the given percentile (0 to 100)
+    uint64_t GetPercentile(double percentile) const;
+
+    nlohmann::json ToJson() const;
+
+private:
+    static const int SubBucketBits = 5;
+    static const int SubBucketCount = 1 << SubBucketBits;
+
+    static int GetBucketIndex(uint64_t value);
+    static uint64_t GetBucketUpperBound(int index);
+
+private:
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_max = 0;
+};
+
+// Per-stage timings of a TrackingPipeline
+struct PipelineStats
+{
+    // Number of captures read from the playback
+    int FrameCount = 0;
+
+    // Wall clock time of the run, not combined by Merge() since it depends on how the runs overlap
+    double ElapsedSeconds = 0;
+
+    // Time spent in k4a_playback_get_next_capture() per capture
+    LatencyHistogram Decode;
+
+    // Captures that the motion gate skipped instead of enqueueing them in the tracker
+    int SkippedFrameCount = 0;
+
+    // Time the reader waited for a slot in the tracker queue and in k4abt_tracker_enqueue_capture() per capture
+    LatencyHistogram Enqueue;
+
+    // Time spent waiting in k4abt_tracker_pop_result() per result
+    LatencyHistogram Pop;
+
+    // Time spent converting and serializing a result, and finishing the output file
+    LatencyHistogram Write;
+    double CloseSeconds = 0;
+
+    // Color images that were released right after decoding instead of going through the tracker
+    uint64_t DroppedColorImageCount = 0;
+    uint64_t DroppedColorBytes = 0;
+
+    void Merge(const PipelineStats& other);
+
+    void Print(std::ostream& output) const;
+    nlohmann::json ToJson() const;
+};
+
+// Microseconds elapsed since start
+inline uint64_t GetElapsedUsec(std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <k4abt.h>
+
+// Information about the clip being processed that is stored alongside the tracking results
+struct ClipInfo
+{
+    std::string SourceFile;
+    std::string SdkVersion = K4ABT_VERSION_STR;
+    std::vector<uint8_t> RawCalibration;
+};
+
+// How the bodies of a frame were obtained
+enum class FrameStatus
+{
+    // The capture went through the tracker
+    Tracked,
+
+    // The capture was skipped by the motion gate, the bodies are the ones of the last tracked frame
+    CarriedForward,
+
+    // The capture was skipped by the motion gate and there were no bodies in the last tracked frame
+    Empty
+};
+
+// Body tracking results of a single capture
+struct FrameResult
+{
+    uint64_t TimestampUsec = 0;
+    int FrameId = 0;
+    FrameStatus Status = FrameStatus::Tracked;
+    std::vector<k4abt_body_t> Bodies;
+
+    // Images of the capture for writers whose WritesCaptures() is true, only valid during ResultWriter::WriteFrame().
+    // BodyIndexMap is null for frames that did not go through the tracker.
+    k4a_capture_t Capture = nullptr;
+    k4a_image_t BodyIndexMap = nullptr;
+};
+
+// Part of an output file that only holds complete frames
+struct OutputPosition
+{
+    uint64_t SizeBytes = 0;
+    uint64_t FrameCount = 0;
+};
+
+// Interface for the different output formats of the offline processor.
+// Frames are passed in the order they are returned by the tracker.
+class ResultWriter
+{
+public:
+    virtual ~ResultWriter() = default;
+
+    virtual bool Open(const char* outputPath, const ClipInfo& clipInfo) = 0;
+
+    virtual bool WriteFrame(const FrameResult& frame) = 0;
+
+    // Formats that store the images next to the results need FrameResult::Capture and FrameResult::BodyIndexMap
+    virtual bool WritesCaptures() const { return false; }
+
+    // Finish the output file. Nothing is guaranteed to be complete on disk before Close() succeeds.
+    virtual bool Close() = 0;
+
+    // Write all frames so far to the output file. Formats that can be continued after an interruption return the
+    // part of the file that holds these frames, the others return false.
+    virtual bool Flush(OutputPosition& /*position*/) { return false; }
+
+    // Continue an output file that was interrupted after Flush() returned position. The rest of the file is dropped.
+    virtual bool Reopen(const char* /*outputPath*/, const ClipInfo& /*clipInfo*/, const OutputPosition& /*position*/) { return false; }
+};
@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "ResumableResultWriter.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Number of frames that are kept for a checkpoint, should cover the warm-up of a resumed run
+const size_t RecentFrameCount = 30;
+
+ResumableResultWriter::ResumableResultWriter(unique_ptr<ResultWriter> writer)
+    : m_writer(move(writer))
+{
+}
+
+bool ResumableResultWriter::Open(const char* outputPath, const ClipInfo& clipInfo)
+{
+    m_recentFrames.clear();
+    m_resumed = false;
+    m_matching = false;
+    m_idMap.clear();
+    m_nextBodyId = 1;
+    return m_writer->Open(outputPath, clipInfo);
+}
+
+bool ResumableResultWriter::Reopen(const char* outputPath, const ClipInfo& clipInfo, const OutputPosition& position)
+{
+    m_recentFrames.clear();
+    m_idMap.clear();
+    return m_writer->Reopen(outputPath, clipInfo, position);
+}
+
+void ResumableResultWriter::SetResumeState(const vector<FrameResult>& recentFrames, uint32_t nextBodyId)
+{
+    m_recentFrames.assign(recentFrames.begin(), recentFrames.end());
+    m_nextBodyId = nextBodyId;
+    m_resumed = true;
+    m_matching = true;
+    m_matcher.Clear();
+}
+
+bool ResumableResultWriter::WriteFrame(const FrameResult& frame)
+{
+    if (frame.FrameId < 0)
+    {
+        if (m_matching)
+        {
+            auto recentFrame = find_if(m_recentFrames.begin(), m_recentFrames.end(),
+                [&](const FrameResult& f) { return f.TimestampUsec == frame.TimestampUsec; });
+            if (recentFrame != m_recentFrames.end())
+            {
+                m_matcher.AddFrame(recentFrame->Bodies, frame.Bodies);
+            }
+        }
+        return true;
+    }
+
+    if (m_matching)
+    {
+        m_idMap = m_matcher.GetMatches();
+        m_matching = false;
+    }
+
+    // The ids of a run that is not resumed are kept as they are
+    m_frame = frame;
+    for (k4abt_body_t& body : m_frame.Bodies)
+    {
+        if (m_resumed)
+        {
+            auto id = m_idMap.find(body.id);
+            if (id == m_idMap.end())
+            {
+                id = m_idMap.insert({ body.id, m_nextBodyId }).first;
+            }
+            body.id = id->second;
+        }
+        m_nextBodyId = max(m_nextBodyId, body.id + 1);
+    }
+
+    m_recentFrames.push_back(m_frame);
+    if (m_recentFrames.size() > RecentFrameCount)
+    {
+        m_recentFrames.pop_front();
+    }
+    return m_writer->WriteFrame(m_frame);
+}
+
+bool ResumableResultWriter::Close()
+{
+    return m_writer->Close();
+}
+
+bool ResumableResultWriter::Flush(OutputPosition& position)
+{
+    return m_writer->Flush(position);
+}
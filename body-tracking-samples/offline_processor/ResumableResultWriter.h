@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "BodyIdMatcher.h"
+#include "ResultWriter.h"
+
+// Wraps the writer of a run that saves checkpoints.
+//
+// The last frames that were written are kept so that they can be stored in a checkpoint. A resumed run starts with a
+// new tracker that numbers the bodies from scratch. Its warm-up frames, which have a FrameId of -1 and are not written,
+// are matched against the frames of the checkpoint to map the new body ids to the ones already in the output.
+class ResumableResultWriter : public ResultWriter
+{
+public:
+    explicit ResumableResultWriter(std::unique_ptr<ResultWriter> writer);
+
+    bool Open(const char* outputPath, const ClipInfo& clipInfo) override;
+    bool WriteFrame(const FrameResult& frame) override;
+    bool Close() override;
+    bool Flush(OutputPosition& position) override;
+    bool Reopen(const char* outputPath, const ClipInfo& clipInfo, const OutputPosition& position) override;
+
+    // Frames and next free body id saved by the checkpoint the run is resumed from, must be called after Reopen()
+    void SetResumeState(const std::vector<FrameResult>& recentFrames, uint32_t nextBodyId);
+
+    const std::deque<FrameResult>& GetRecentFrames() const { return m_recentFrames; }
+    uint32_t GetNextBodyId() const { return m_nextBodyId; }
+
+private:
+    std::unique_ptr<ResultWriter> m_writer;
+
+    std::deque<FrameResult> m_recentFrames;
+    FrameResult m_frame;
+
+    bool m_resumed = false;
+    bool m_matching = false;
+    BodyIdMatcher m_matcher;
+    std::map<uint32_t, uint32_t> m_idMap;
+    uint32_t m_nextBodyId = 1;
+};
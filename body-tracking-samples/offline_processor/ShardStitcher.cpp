@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "ShardStitcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "BinaryResultWriter.h"
+#include "SkeletonBinaryReader.h"
+
+using namespace std;
+
+ShardStitcher::ShardStitcher(ResultWriter& writer)
+    : m_writer(writer)
+{
+}
+
+bool ShardStitcher::Stitch(const vector<ShardResult>& shards)
+{
+    m_idMap.clear();
+    m_nextId = 1;
+    m_isFirstShard = true;
+    m_nextWarmupFrames.clear();
+    m_matcher.Clear();
+
+    int frameIdOffset = 0;
+    SkeletonBinary::FrameHeader frameHeader;
+    vector<SkeletonBinary::BodyRecord> bodyRecords;
+    FrameResult frame;
+    for (size_t shardIndex = 0; shardIndex < shards.size(); shardIndex++)
+    {
+        if (shardIndex + 1 < shards.size() && !LoadWarmupFrames(shards[shardIndex + 1]))
+        {
+            return false;
+        }
+
+        SkeletonBinaryReader reader;
+        if (!reader.Open(shards[shardIndex].Path.c_str()))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < reader.GetFrameCount(); i++)
+        {
+            if (!reader.ReadFrame(i, frameHeader, bodyRecords))
+            {
+                cerr << "Failed to read frame " << i << " of " << shards[shardIndex].Path << endl;
+                return false;
+            }
+            if (frameHeader.FrameId < 0)
+            {
+                continue;
+            }
+
+            frame.TimestampUsec = frameHeader.TimestampUsec;
+            frame.FrameId = frameHeader.FrameId + frameIdOffset;
+            frame.Status = ToFrameStatus(frameHeader.Flags);
+            frame.Bodies.resize(bodyRecords.size());
+            for (size_t j = 0; j < bodyRecords.size(); j++)
+            {
+                frame.Bodies[j] = SkeletonBinary::ToBody(bodyRecords[j]);
+                frame.Bodies[j].id = GetGlobalId(bodyRecords[j].Id);
+            }
+
+            auto warmupFrame = m_nextWarmupFrames.find(frame.TimestampUsec);
+            if (warmupFrame != m_nextWarmupFrames.end())
+            {
+                m_matcher.AddFrame(frame.Bodies, warmupFrame->second);
+            }
+
+            if (!m_writer.WriteFrame(frame))
+            {
+                return false;
+            }
+        }
+
+        frameIdOffset += shards[shardIndex].FrameCount;
+        m_isFirstShard = false;
+        m_idMap = m_matcher.GetMatches();
+    }
+    return true;
+}
+
+bool ShardStitcher::LoadWarmupFrames(const ShardResult& shard)
+{
+    m_nextWarmupFrames.clear();
+    m_matcher.Clear();
+
+    SkeletonBinaryReader reader;
+    if (!reader.Open(shard.Path.c_str()))
+    {
+        return false;
+    }
+
+    // The warm-up frames are at the start of the shard
+    SkeletonBinary::FrameHeader frameHeader;
+    vector<SkeletonBinary::BodyRecord> bodyRecords;
+    for (size_t i = 0; i < reader.GetFrameCount(); i++)
+    {
+        if (!reader.ReadFrame(i, frameHeader, bodyRecords))
+        {
+            return false;
+        }
+        if (frameHeader.FrameId >= 0)
+        {
+            break;
+        }
+
+        vector<k4abt_body_t>& bodies = m_nextWarmupFrames[frameHeader.TimestampUsec];
+        for (const SkeletonBinary::BodyRecord& record : bodyRecords)
+        {
+            bodies.push_back(SkeletonBinary::ToBody(record));
+        }
+    }
+    return true;
+}
+
+uint32_t ShardStitcher::GetGlobalId(uint32_t shardId)
+{
+    auto id = m_idMap.find(shardId);
+    if (id != m_idMap.end())
+    {
+        return id->second;
+    }
+
+    // Bodies of the first shard keep the ids of the tracker, unmatched bodies of later shards get a new id
+    uint32_t globalId = m_isFirstShard ? shardId : m_nextId;
+    m_nextId = max(m_nextId, globalId + 1);
+    m_idMap[shardId] = globalId;
+    return globalId;
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BodyIdMatcher.h"
+#include "ResultWriter.h"
+
+// Results of one time range of a recording that was tracked by its own tracker
+struct ShardResult
+{
+    // Binary result file of the shard. The warm-up frames that overlap the previous shard are written with a FrameId
+    // of -1, the other frame ids start at 0 for every shard.
+    std::string Path;
+
+    // Number of captures of the shard, not counting the warm-up captures
+    int FrameCount = 0;
+};
+
+// Merges the results of the shards of a recording into a single result as if it was tracked front to back.
+//
+// Every tracker numbers its bodies on its own, so the body ids of a shard are matched to the ids of the previous
+// shard through the warm-up frames that both shards tracked. Bodies without a match get a new id.
+class ShardStitcher
+{
+public:
+    explicit ShardStitcher(ResultWriter& writer);
+
+    // The shards must be in time order. The writer must be open, it is not closed.
+    bool Stitch(const std::vector<ShardResult>& shards);
+
+private:
+    bool LoadWarmupFrames(const ShardResult& shard);
+    uint32_t GetGlobalId(uint32_t shardId);
+
+private:
+    ResultWriter& m_writer;
+
+    // Body ids of the current shard mapped to the ids of the stitched result
+    std::map<uint32_t, uint32_t> m_idMap;
+    uint32_t m_nextId = 1;
+    bool m_isFirstShard = true;
+
+    // Warm-up frames of the next shard by timestamp, matched against the frames of the current shard
+    std::map<uint64_t, std::vector<k4abt_body_t>> m_nextWarmupFrames;
+    BodyIdMatcher m_matcher;
+};
@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <k4abttypes.h>
+
+// Binary body tracking result file written by the offline processor ("-format binary").
+//
+// All values are little-endian. The file is laid out as:
+//
+//   FileHeader
+//   Header payload, each string is a uint32_t byte length followed by the characters (no terminating zero):
+//       k4abt sdk version string
+//       source file string
+//       JointCount joint name strings
+//       BoneCount pairs of uint32_t joint indices
+//       uint32_t byte length followed by the raw calibration blob of the recording
+//   Zero padding up to FileHeader::HeaderSize
+//   Frame records, one per processed capture:
+//       FrameHeader
+//       FrameHeader::NumBodies BodyRecord entries of FileHeader::BodyRecordSize bytes each
+//   Frame index: FileFooter::FrameCount uint64_t absolute file offsets of the frame records
+//   FileFooter
+//
+// All records have a fixed size, so the file can be memory-mapped and any frame can be located in O(1) through the
+// frame index at the end of the file.
+namespace SkeletonBinary
+{
+    const char FileMagic[8] = { 'K', '4', 'A', 'B', 'T', 'S', 'K', 'L' };
+    const char IndexMagic[8] = { 'K', '4', 'A', 'B', 'T', 'I', 'D', 'X' };
+    const uint32_t FormatVersion = 1;
+
+    // FrameHeader::Flags of the captures that were skipped by the motion gate of the offline processor. The bodies of
+    // a carried forward frame are the ones of the last tracked frame, an empty frame has no bodies.
+    const uint32_t FrameFlagCarriedForward = 1 << 0;
+    const uint32_t FrameFlagEmpty = 1 << 1;
+
+    // Offsets of the frame records and the frame index are aligned to this size
+    const uint32_t RecordAlignment = 8;
+
+    struct FileHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t HeaderSize;        // Offset of the first frame record
+        uint32_t JointCount;
+        uint32_t BoneCount;
+        uint32_t BodyRecordSize;
+        uint32_t Reserved;
+    };
+
+    struct FrameHeader
+    {
+        uint64_t TimestampUsec;
+        int32_t FrameId;
+        uint32_t NumBodies;
+        uint32_t Flags;
+        uint32_t Reserved;
+    };
+
+    struct BodyRecord
+    {
+        uint32_t Id;
+        uint32_t Reserved;
+        float Positions[K4ABT_JOINT_COUNT][3];      // x, y, z in millimeters
+        float Orientations[K4ABT_JOINT_COUNT][4];   // w, x, y, z
+        uint8_t Confidences[K4ABT_JOINT_COUNT];     // k4abt_joint_confidence_level_t
+    };
+
+    struct FileFooter
+    {
+        uint64_t IndexOffset;
+        uint64_t FrameCount;
+        char Magic[8];
+    };
+
+    static_assert(sizeof(FileHeader) == 32, "Unexpected padding in FileHeader");
+    static_assert(sizeof(FrameHeader) == 24, "Unexpected padding in FrameHeader");
+    static_assert(sizeof(BodyRecord) % RecordAlignment == 0, "BodyRecord must keep the records aligned");
+    static_assert(sizeof(FileFooter) == 24, "Unexpected padding in FileFooter");
+
+    inline bool IsLittleEndianHost()
+    {
+        const uint16_t value = 1;
+        return *reinterpret_cast<const uint8_t*>(&value) == 1;
+    }
+
+    inline BodyRecord ToBodyRecord(const k4abt_body_t& body)
+    {
+        BodyRecord record = {};
+        record.Id = body.id;
+        for (int j = 0; j < (int)K4ABT_JOINT_COUNT; j++)
+        {
+            const k4abt_joint_t& joint = body.skeleton.joints[j];
+            for (int k = 0; k < 3; k++)
+            {
+                record.Positions[j][k] = joint.position.v[k];
+            }
+            for (int k = 0; k < 4; k++)
+            {
+                record.Orientations[j][k] = joint.orientation.v[k];
+            }
+            record.Confidences[j] = static_cast<uint8_t>(joint.confidence_level);
+        }
+        return record;
+    }
+
+    inline k4abt_body_t ToBody(const BodyRecord& record)
+    {
+        k4abt_body_t body = {};
+        body.id = record.Id;
+        for (int j = 0; j < (int)K4ABT_JOINT_COUNT; j++)
+        {
+            k4abt_joint_t& joint = body.skeleton.joints[j];
+            for (int k = 0; k < 3; k++)
+            {
+                joint.position.v[k] = record.Positions[j][k];
+            }
+            for (int k = 0; k < 4; k++)
+            {
+                joint.orientation.v[k] = record.Orientations[j][k];
+            }
+            joint.confidence_level = static_cast<k4abt_joint_confidence_level_t>(record.Confidences[j]);
+        }
+        return body;
+    }
+}
@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "SkeletonBinaryReader.h"
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+using namespace SkeletonBinary;
+
+bool SkeletonBinaryReader::Open(const char* path)
+{
+    Close();
+
+    if (!IsLittleEndianHost())
+    {
+        cerr << "The binary output format is only supported on little-endian hosts" << endl;
+        return false;
+    }
+
+    m_file.open(path, ios::in | ios::binary);
+    if (!m_file.is_open())
+    {
+        cerr << "Cannot open " << path << endl;
+        return false;
+    }
+
+    FileHeader header;
+    if (!Read(&header, sizeof(header)) || memcmp(header.Magic, FileMagic, sizeof(header.Magic)) != 0)
+    {
+        cerr << path << " is not a body tracking binary file" << endl;
+        return false;
+    }
+
+    if (header.Version != FormatVersion ||
+        header.JointCount != K4ABT_JOINT_COUNT ||
+        header.BodyRecordSize != sizeof(BodyRecord))
+    {
+        cerr << "Unsupported body tracking binary file version " << header.Version << endl;
+        return false;
+    }
+
+    if (!ReadString(m_sdkVersion) || !ReadString(m_sourceFile))
+    {
+        return false;
+    }
+
+    m_jointNames.resize(header.JointCount);
+    for (string& jointName : m_jointNames)
+    {
+        if (!ReadString(jointName))
+        {
+            return false;
+        }
+    }
+
+    m_boneList.resize(header.BoneCount);
+    for (auto& bone : m_boneList)
+    {
+        uint32_t joints[2];
+        if (!Read(joints, sizeof(joints)))
+        {
+            return false;
+        }
+        bone = { joints[0], joints[1] };
+    }
+
+    uint32_t calibrationSize = 0;
+    if (!Read(&calibrationSize, sizeof(calibrationSize)))
+    {
+        return false;
+    }
+    m_rawCalibration.resize(calibrationSize);
+    if (!Read(m_rawCalibration.data(), m_rawCalibration.size()))
+    {
+        return false;
+    }
+
+    // The frame index is located through the footer at the end of the file
+    FileFooter footer;
+    m_file.seekg(-static_cast<streamoff>(sizeof(footer)), ios::end);
+    if (!Read(&footer, sizeof(footer)) || memcmp(footer.Magic, IndexMagic, sizeof(footer.Magic)) != 0)
+    {
+        cerr << path << " has no frame index. The file is incomplete." << endl;
+        return false;
+    }
+
+    m_frameOffsets.resize(footer.FrameCount);
+    m_file.seekg(static_cast<streamoff>(footer.IndexOffset));
+    return Read(m_frameOffsets.data(), m_frameOffsets.size() * sizeof(uint64_t));
+}
+
+void SkeletonBinaryReader::Close()
+{
+    if (m_file.is_open())
+    {
+        m_file.close();
+    }
+    m_file.clear();
+
+    m_sdkVersion.clear();
+    m_sourceFile.clear();
+    m_jointNames.clear();
+    m_boneList.clear();
+    m_rawCalibration.clear();
+    m_frameOffsets.clear();
+}
+
+bool SkeletonBinaryReader::ReadFrame(size_t frameIndex, FrameHeader& frameHeader, vector<BodyRecord>& bodies)
+{
+    if (frameIndex >= m_frameOffsets.size())
+    {
+        return false;
+    }
+
+    m_file.seekg(static_cast<streamoff>(m_frameOffsets[frameIndex]));
+    if (!Read(&frameHeader, sizeof(frameHeader)))
+    {
+        return false;
+    }
+
+    bodies.resize(frameHeader.NumBodies);
+    return Read(bodies.data(), bodies.size() * sizeof(BodyRecord));
+}
+
+bool SkeletonBinaryReader::Read(void* data, size_t size)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+
+    m_file.read(static_cast<char*>(data), static_cast<streamsize>(size));
+    if (!m_file.good())
+    {
+        cerr << "Unexpected end of body tracking binary file" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool SkeletonBinaryReader::ReadString(string& value)
+{
+    uint32_t length = 0;
+    if (!Read(&length, sizeof(length)))
+    {
+        return false;
+    }
+    value.resize(length);
+    return Read(&value[0], length);
+}
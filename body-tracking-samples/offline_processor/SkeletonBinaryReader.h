@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SkeletonBinaryFormat.h"
+
+// Reads the binary body tracking result files written by the offline processor.
+// Any frame can be read directly through the frame index without parsing the frames before it.
+class SkeletonBinaryReader
+{
+public:
+    bool Open(const char* path);
+    void Close();
+
+    const std::string& GetSdkVersion() const { return m_sdkVersion; }
+    const std::string& GetSourceFile() const { return m_sourceFile; }
+    const std::vector<std::string>& GetJointNames() const { return m_jointNames; }
+    const std::vector<std::pair<uint32_t, uint32_t>>& GetBoneList() const { return m_boneList; }
+
+    // Raw calibration blob of the recording, can be passed to k4a_calibration_get_from_raw()
+    const std::vector<uint8_t>& GetRawCalibration() const { return m_rawCalibration; }
+
+    size_t GetFrameCount() const { return m_frameOffsets.size(); }
+
+    bool ReadFrame(size_t frameIndex, SkeletonBinary::FrameHeader& frameHeader, std::vector<SkeletonBinary::BodyRecord>& bodies);
+
+private:
+    bool Read(void* data, size_t size);
+    bool ReadString(std::string& value);
+
+private:
+    std::ifstream m_file;
+    std::string m_sdkVersion;
+    std::string m_sourceFile;
+    std::vector<std::string> m_jointNames;
+    std::vector<std::pair<uint32_t, uint32_t>> m_boneList;
+    std::vector<uint8_t> m_rawCalibration;
+    std::vector<uint64_t> m_frameOffsets;
+};
@@ -0,0 +1,358 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "TrackingPipeline.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <Utilities.h>
+
+using namespace std;
+
+bool check_depth_image_exists(k4a_capture_t capture)
+{
+    k4a_image_t depth = k4a_capture_get_depth_image(capture);
+    if (depth != nullptr)
+    {
+        k4a_image_release(depth);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// The tracker only uses the depth and IR images. The color image is released right after it is read, so its buffer
+// is not kept alive while the capture waits in the tracker queue. Returns the size of the released image.
+size_t drop_color_image(k4a_capture_t capture)
+{
+    k4a_image_t color = k4a_capture_get_color_image(capture);
+    if (color == nullptr)
+    {
+        return 0;
+    }
+
+    size_t colorSize = k4a_image_get_size(color);
+    k4a_image_release(color);
+    k4a_capture_set_color_image(capture, nullptr);
+    return colorSize;
+}
+
+uint64_t get_capture_device_timestamp_usec(k4a_capture_t capture)
+{
+    k4a_image_t image = k4a_capture_get_depth_image(capture);
+    if (image == nullptr)
+    {
+        image = k4a_capture_get_ir_image(capture);
+    }
+    if (image == nullptr)
+    {
+        image = k4a_capture_get_color_image(capture);
+    }
+    if (image == nullptr)
+    {
+        return 0;
+    }
+
+    uint64_t timestamp = k4a_image_get_device_timestamp_usec(image);
+    k4a_image_release(image);
+    return timestamp;
+}
+
+TrackingPipeline::TrackingPipeline(k4a_playback_t playback, k4abt_tracker_t tracker, ResultWriter& writer, int queueDepth)
+    : m_playback(playback)
+    , m_tracker(tracker)
+    , m_writer(writer)
+    , m_queueDepth(queueDepth < 1 ? 1 : queueDepth)
+{
+}
+
+bool TrackingPipeline::Run()
+{
+    m_frameCount = 0;
+    m_frameResult = FrameResult();
+    m_pendingFrames.clear();
+    m_trackerFrameCount = 0;
+    m_readerDone = false;
+    m_failed = false;
+    m_stats = PipelineStats();
+    m_writtenFrameCount = 0;
+    m_motionGate.reset();
+    if (m_motionGateEnabled)
+    {
+        m_motionGate = make_unique<MotionGate>(m_motionGateConfig);
+    }
+    auto startTime = chrono::steady_clock::now();
+
+    if (m_range.WarmupStartUsec > 0 &&
+        K4A_RESULT_SUCCEEDED != k4a_playback_seek_timestamp(m_playback, (int64_t)m_range.WarmupStartUsec, K4A_PLAYBACK_SEEK_DEVICE_TIME))
+    {
+        cerr << "Failed to seek the recording to " << m_range.WarmupStartUsec << " usec" << endl;
+        return false;
+    }
+
+    thread readerThread(&TrackingPipeline::ReadCaptures, this);
+    ConsumeResults();
+    readerThread.join();
+
+    // Captures of skipped frames that were not written because of an error
+    for (PendingFrame& pendingFrame : m_pendingFrames)
+    {
+        if (pendingFrame.Capture != nullptr)
+        {
+            k4a_capture_release(pendingFrame.Capture);
+        }
+    }
+    m_pendingFrames.clear();
+
+    m_stats.FrameCount = m_frameCount;
+    m_stats.ElapsedSeconds = GetElapsedUsec(startTime) / 1e6;
+    return !m_failed;
+}
+
+void TrackingPipeline::ReadCaptures()
+{
+    while (true)
+    {
+        k4a_capture_t captureHandle = nullptr;
+        auto decodeStartTime = chrono::steady_clock::now();
+        k4a_stream_result_t streamResult = k4a_playback_get_next_capture(m_playback, &captureHandle);
+        m_stats.Decode.Record(GetElapsedUsec(decodeStartTime));
+        if (streamResult == K4A_STREAM_RESULT_EOF)
+        {
+            break;
+        }
+
+        if (streamResult != K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            cerr << "Stream error for clip at frame " << m_frameCount << endl;
+            Fail();
+            break;
+        }
+
+        // The timestamp is read before the color image is dropped, so a capture with only a color image keeps its
+        // timestamp and is counted like in a front-to-back run.
+        uint64_t timestamp = get_capture_device_timestamp_usec(captureHandle);
+
+        size_t colorSize = drop_color_image(captureHandle);
+        if (colorSize > 0)
+        {
+            m_stats.DroppedColorImageCount++;
+            m_stats.DroppedColorBytes += colorSize;
+        }
+        if (timestamp >= m_range.EndUsec)
+        {
+            k4a_capture_release(captureHandle);
+            break;
+        }
+
+        int frameId = -1;
+        if (timestamp >= m_range.EmitStartUsec)
+        {
+            frameId = m_range.FirstFrameId + m_frameCount++;
+            if (m_printProgress)
+            {
+                cout << "frame " << frameId << '\r';
+            }
+        }
+
+        // Only try to predict joints when capture contains depth image
+        if (!check_depth_image_exists(captureHandle))
+        {
+            k4a_capture_release(captureHandle);
+            continue;
+        }
+
+        // Captures without a significant change to the background keep the bodies of the last tracked capture.
+        // Warm-up captures are always tracked since they prepare the tracker for the emitted captures.
+        if (m_motionGate)
+        {
+            k4a_image_t depthImage = k4a_capture_get_depth_image(captureHandle);
+            bool track = m_motionGate->ShouldTrack(depthImage);
+            k4a_image_release(depthImage);
+            if (!track && frameId >= 0)
+            {
+                // The capture is kept until it is written if the writer stores the images
+                if (!m_writer.WritesCaptures())
+                {
+                    k4a_capture_release(captureHandle);
+                    captureHandle = nullptr;
+                }
+                m_stats.SkippedFrameCount++;
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_pendingFrames.push_back({ frameId, timestamp, true, captureHandle });
+                }
+                m_condition.notify_all();
+                continue;
+            }
+        }
+
+        // Wait for a free slot in the tracker queue
+        auto enqueueStartTime = chrono::steady_clock::now();
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_failed || m_trackerFrameCount < m_queueDepth; });
+            if (m_failed)
+            {
+                k4a_capture_release(captureHandle);
+                break;
+            }
+        }
+
+        k4a_wait_result_t queueCaptureResult = k4abt_tracker_enqueue_capture(m_tracker, captureHandle, K4A_WAIT_INFINITE);
+        k4a_capture_release(captureHandle);
+        m_stats.Enqueue.Record(GetElapsedUsec(enqueueStartTime));
+        if (queueCaptureResult != K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            cerr << "Error! Adding capture to tracker process queue failed at frame " << frameId << endl;
+            Fail();
+            break;
+        }
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_pendingFrames.push_back({ frameId, timestamp, false, nullptr });
+            m_trackerFrameCount++;
+        }
+        m_condition.notify_all();
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_readerDone = true;
+    }
+    m_condition.notify_all();
+}
+
+void TrackingPipeline::ConsumeResults()
+{
+    while (true)
+    {
+        PendingFrame pendingFrame;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_failed || m_readerDone || !m_pendingFrames.empty(); });
+            if (m_failed || m_pendingFrames.empty())
+            {
+                // Either an error happened or the reader is done and every result has been popped
+                break;
+            }
+            pendingFrame = m_pendingFrames.front();
+
+            // The consumer owns the capture from here on
+            m_pendingFrames.front().Capture = nullptr;
+        }
+        int frameId = pendingFrame.FrameId;
+
+        uint64_t convertUsec = 0;
+        if (pendingFrame.Skipped)
+        {
+            // Every frame before this one has been handled, so m_frameResult holds the last tracked bodies
+            m_frameResult.TimestampUsec = pendingFrame.TimestampUsec;
+            m_frameResult.FrameId = frameId;
+            m_frameResult.Status = m_frameResult.Bodies.empty() ? FrameStatus::Empty : FrameStatus::CarriedForward;
+            m_frameResult.Capture = pendingFrame.Capture;
+        }
+        else
+        {
+            // The capture of this frame is already in the tracker, so an infinite wait always returns
+            k4abt_frame_t bodyFrame = nullptr;
+            auto popStartTime = chrono::steady_clock::now();
+            k4a_wait_result_t popFrameResult = k4abt_tracker_pop_result(m_tracker, &bodyFrame, K4A_WAIT_INFINITE);
+            m_stats.Pop.Record(GetElapsedUsec(popStartTime));
+            if (popFrameResult != K4A_WAIT_RESULT_SUCCEEDED)
+            {
+                cerr << "Error! Popping body tracking result failed at frame " << frameId << endl;
+                Fail();
+                break;
+            }
+
+            auto convertStartTime = chrono::steady_clock::now();
+            ConvertBodyFrame(bodyFrame, frameId);
+            if (m_writer.WritesCaptures())
+            {
+                m_frameResult.Capture = k4abt_frame_get_capture(bodyFrame);
+                m_frameResult.BodyIndexMap = k4abt_frame_get_body_index_map(bodyFrame);
+            }
+            k4abt_frame_release(bodyFrame);
+            convertUsec = GetElapsedUsec(convertStartTime);
+        }
+
+        // Warm-up frames only feed the temporal tracking of the tracker
+        bool writeSucceeded = true;
+        if (frameId >= 0 || m_range.WriteWarmupFrames)
+        {
+            auto writeStartTime = chrono::steady_clock::now();
+            writeSucceeded = m_writer.WriteFrame(m_frameResult);
+            m_stats.Write.Record(convertUsec + GetElapsedUsec(writeStartTime));
+
+            if (writeSucceeded && frameId >= 0 && m_checkpointCallback &&
+                m_checkpointInterval > 0 && ++m_writtenFrameCount % m_checkpointInterval == 0)
+            {
+                writeSucceeded = m_checkpointCallback(m_frameResult);
+            }
+        }
+        ReleaseFrameImages();
+        if (!writeSucceeded)
+        {
+            cerr << "Writing results failed at frame " << frameId << endl;
+            Fail();
+            break;
+        }
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (!pendingFrame.Skipped)
+            {
+                m_trackerFrameCount--;
+            }
+            m_pendingFrames.pop_front();
+        }
+        m_condition.notify_all();
+    }
+}
+
+void TrackingPipeline::ReleaseFrameImages()
+{
+    if (m_frameResult.Capture != nullptr)
+    {
+        k4a_capture_release(m_frameResult.Capture);
+        m_frameResult.Capture = nullptr;
+    }
+    if (m_frameResult.BodyIndexMap != nullptr)
+    {
+        k4a_image_release(m_frameResult.BodyIndexMap);
+        m_frameResult.BodyIndexMap = nullptr;
+    }
+}
+
+void TrackingPipeline::ConvertBodyFrame(k4abt_frame_t bodyFrame, int frameId)
+{
+    uint32_t numBodies = k4abt_frame_get_num_bodies(bodyFrame);
+    m_frameResult.TimestampUsec = k4abt_frame_get_device_timestamp_usec(bodyFrame);
+    m_frameResult.FrameId = frameId;
+    m_frameResult.Status = FrameStatus::Tracked;
+    m_frameResult.Bodies.resize(numBodies);
+    for (uint32_t i = 0; i < numBodies; i++)
+    {
+        k4abt_body_t& body = m_frameResult.Bodies[i];
+        VERIFY(k4abt_frame_get_body_skeleton(bodyFrame, i, &body.skeleton), "Get body from body frame failed!");
+        body.id = k4abt_frame_get_body_id(bodyFrame, i);
+    }
+}
+
+void TrackingPipeline::Fail()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_failed = true;
+    }
+    m_condition.notify_all();
+
+    // Unblock a reader that may be waiting in k4abt_tracker_enqueue_capture() for a full tracker queue
+    k4abt_tracker_shutdown(m_tracker);
+}
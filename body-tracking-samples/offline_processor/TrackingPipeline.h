@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <k4a/k4a.h>
+#include <k4arecord/playback.h>
+#include <k4abt.h>
+
+#include "MotionGate.h"
+#include "PipelineStats.h"
+#include "ResultWriter.h"
+
+// Device time range of a recording that is tracked by a TrackingPipeline.
+//
+// Captures before EmitStartUsec are only used to warm up the tracker. Their results are not written unless
+// WriteWarmupFrames is set, in which case they are written with a FrameId of -1. Frame ids count the captures from
+// EmitStartUsec on, starting at FirstFrameId. Captures are assigned to a range by the device timestamp of their depth
+// image.
+struct TrackRange
+{
+    uint64_t WarmupStartUsec = 0;
+    uint64_t EmitStartUsec = 0;
+    uint64_t EndUsec = UINT64_MAX;
+    int FirstFrameId = 0;
+    bool WriteWarmupFrames = false;
+};
+
+// Called after every intervalFrames written frames with the last written frame
+using CheckpointCallback = std::function<bool(const FrameResult& lastFrame)>;
+
+// Runs a recording through a body tracker and hands the results to a ResultWriter.
+//
+// A reader thread decodes captures from the playback and keeps pushing them to the tracker while a consumer thread
+// pops the tracking results and serializes them. Up to queueDepth captures are in flight in the tracker at any time,
+// so MKV decoding, inference and serialization overlap instead of running one after another.
+class TrackingPipeline
+{
+public:
+    TrackingPipeline(k4a_playback_t playback, k4abt_tracker_t tracker, ResultWriter& writer, int queueDepth);
+
+    // Process the playback until the end of the recording. Returns false on the first error.
+    bool Run();
+
+    // Only track a part of the recording, the playback is sought to range.WarmupStartUsec when Run() starts
+    void SetTrackRange(const TrackRange& range) { m_range = range; }
+
+    // Periodically call checkpointCallback from the consumer thread, e.g. to flush the output and save the progress.
+    // A failing callback stops the run.
+    void SetCheckpointCallback(int intervalFrames, CheckpointCallback checkpointCallback)
+    {
+        m_checkpointInterval = intervalFrames;
+        m_checkpointCallback = std::move(checkpointCallback);
+    }
+
+    // Skip the captures that the motion gate finds unchanged instead of tracking them. They are written as
+    // FrameStatus::CarriedForward or FrameStatus::Empty frames with the bodies of the last tracked capture.
+    void SetMotionGate(const MotionGateConfig& config)
+    {
+        m_motionGateEnabled = true;
+        m_motionGateConfig = config;
+    }
+
+    // Print the index of the capture that is read, on by default
+    void SetPrintProgress(bool printProgress) { m_printProgress = printProgress; }
+
+    // Number of captures read from the playback, not counting the warm-up captures
+    int GetFrameCount() const { return m_frameCount; }
+
+    // Per-stage timings of the last Run(), the writer is not closed by the pipeline
+    const PipelineStats& GetStats() const { return m_stats; }
+
+private:
+    void ReadCaptures();
+    void ConsumeResults();
+    void ConvertBodyFrame(k4abt_frame_t bodyFrame, int frameId);
+    void ReleaseFrameImages();
+    void Fail();
+
+private:
+    k4a_playback_t m_playback = nullptr;
+    k4abt_tracker_t m_tracker = nullptr;
+    ResultWriter& m_writer;
+    int m_queueDepth = 1;
+    bool m_printProgress = true;
+    TrackRange m_range;
+    int m_checkpointInterval = 0;
+    CheckpointCallback m_checkpointCallback;
+    int m_writtenFrameCount = 0;
+    bool m_motionGateEnabled = false;
+    MotionGateConfig m_motionGateConfig;
+    std::unique_ptr<MotionGate> m_motionGate;
+
+    int m_frameCount = 0;
+    FrameResult m_frameResult;
+    PipelineStats m_stats;
+
+    // A capture that was read but whose result is not written yet
+    struct PendingFrame
+    {
+        int FrameId = 0;
+        uint64_t TimestampUsec = 0;
+
+        // Skipped by the motion gate instead of being enqueued in the tracker
+        bool Skipped = false;
+
+        // Capture of a skipped frame for writers that store the images
+        k4a_capture_t Capture = nullptr;
+    };
+
+    // Captures in read order. The tracker returns results in the order the captures were enqueued, so the skipped
+    // captures stay in order with the tracked ones. m_trackerFrameCount of them are in the tracker.
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<PendingFrame> m_pendingFrames;
+    int m_trackerFrameCount = 0;
+    bool m_readerDone = false;
+    bool m_failed = false;
+};
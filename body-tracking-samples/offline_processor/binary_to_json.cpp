@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <iostream>
+
+#include <BodyTrackingHelpers.h>
+
+#include "BinaryResultWriter.h"
+#include "JsonResultWriter.h"
+#include "SkeletonBinaryReader.h"
+
+using namespace std;
+
+// Converts a binary result file of the offline processor to the json format of the offline processor
+bool convert_binary_to_json(const char* input_path, const char* output_path)
+{
+    SkeletonBinaryReader reader;
+    if (!reader.Open(input_path))
+    {
+        return false;
+    }
+
+    // The json format always uses the joint names of the helper includes
+    const vector<string>& joint_names = reader.GetJointNames();
+    for (int i = 0; i < (int)K4ABT_JOINT_COUNT; i++)
+    {
+        if (joint_names[i] != g_jointNames.find((k4abt_joint_id_t)i)->second)
+        {
+            cerr << "Joint " << i << " of " << input_path << " is " << joint_names[i] << " instead of "
+                 << g_jointNames.find((k4abt_joint_id_t)i)->second << endl;
+            return false;
+        }
+    }
+
+    ClipInfo clip_info;
+    clip_info.SdkVersion = reader.GetSdkVersion();
+    clip_info.SourceFile = reader.GetSourceFile();
+    clip_info.RawCalibration = reader.GetRawCalibration();
+
+    JsonStreamResultWriter writer;
+    if (!writer.Open(output_path, clip_info))
+    {
+        return false;
+    }
+
+    SkeletonBinary::FrameHeader frame_header;
+    vector<SkeletonBinary::BodyRecord> body_records;
+    FrameResult frame_result;
+    for (size_t i = 0; i < reader.GetFrameCount(); i++)
+    {
+        if (!reader.ReadFrame(i, frame_header, body_records))
+        {
+            cerr << "Failed to read frame " << i << " of " << input_path << endl;
+            return false;
+        }
+
+        frame_result.TimestampUsec = frame_header.TimestampUsec;
+        frame_result.FrameId = frame_header.FrameId;
+        frame_result.Status = ToFrameStatus(frame_header.Flags);
+        frame_result.Bodies.resize(body_records.size());
+        for (size_t j = 0; j < body_records.size(); j++)
+        {
+            frame_result.Bodies[j] = SkeletonBinary::ToBody(body_records[j]);
+        }
+
+        if (!writer.WriteFrame(frame_result))
+        {
+            return false;
+        }
+    }
+
+    if (!writer.Close())
+    {
+        return false;
+    }
+
+    cout << "Converted " << reader.GetFrameCount() << " frames to " << output_path << endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        cout << "Usage: offline_processor_binary_to_json <input_binary_file> <output_json_file>" << endl;
+        return -1;
+    }
+    return convert_binary_to_json(argv[1], argv[2]) ? 0 : -1;
+}
@@ -1,91 +1,131 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
-#include <string>
 #include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <k4a/k4a.h>
 #include <k4arecord/playback.h>
 #include <k4abt.h>
-#include <nlohmann/json.hpp>
 
-#include <BodyTrackingHelpers.h>
 #include <Utilities.h>
 
+#include "BatchProcessor.h"
+#include "BinaryResultWriter.h"
+#include "Checkpoint.h"
+#include "JsonResultWriter.h"
+#include "MkvResultWriter.h"
+#include "MotionGate.h"
+#include "PipelineStats.h"
+#include "ResumableResultWriter.h"
+#include "ShardStitcher.h"
+#include "TrackingPipeline.h"
+
 using namespace std;
-using namespace nlohmann;
 
-bool predict_joints(json &frames_json, int frame_count, k4abt_tracker_t tracker, k4a_capture_t capture_handle)
+enum class OutputFormat
 {
-    k4a_wait_result_t queue_capture_result = k4abt_tracker_enqueue_capture(tracker, capture_handle, K4A_WAIT_INFINITE);
-    if (queue_capture_result != K4A_WAIT_RESULT_SUCCEEDED)
-    {
-        cerr << "Error! Adding capture to tracker process queue failed!" << endl;
-        return false;
-    }
+    Json,
+    JsonStream,
+    Binary,
+    Mkv
+};
 
-    k4abt_frame_t body_frame = nullptr;
-    k4a_wait_result_t pop_frame_result = k4abt_tracker_pop_result(tracker, &body_frame, K4A_WAIT_INFINITE);
-    if (pop_frame_result != K4A_WAIT_RESULT_SUCCEEDED)
-    {
-        cerr << "Error! Popping body tracking result failed!" << endl;
-        return false;
-    }
+struct ProcessingOptions
+{
+    OutputFormat Format = OutputFormat::Json;
+    int QueueDepth = 1;
+    int ShardCount = 1;
 
-    uint32_t num_bodies = k4abt_frame_get_num_bodies(body_frame);
-    uint64_t timestamp = k4abt_frame_get_device_timestamp_usec(body_frame);
+    // Save a checkpoint every CheckpointInterval frames, continue from the last checkpoint if Resume is set
+    int CheckpointInterval = 0;
+    bool Resume = false;
 
-    json frame_result_json;
-    frame_result_json["timestamp_usec"] = timestamp;
-    frame_result_json["frame_id"] = frame_count;
-    frame_result_json["num_bodies"] = num_bodies;
-    frame_result_json["bodies"] = json::array();
-    for (uint32_t i = 0; i < num_bodies; i++)
-    {
-        k4abt_skeleton_t skeleton;
-        VERIFY(k4abt_frame_get_body_skeleton(body_frame, i, &skeleton), "Get body from body frame failed!");
-        json body_result_json;
-        int body_id = k4abt_frame_get_body_id(body_frame, i);
-        body_result_json["body_id"] = body_id;
+    // Skip the captures without motion instead of tracking them
+    bool MotionGateEnabled = false;
+    MotionGateConfig GateConfig;
 
-        for (int j = 0; j < (int)K4ABT_JOINT_COUNT; j++)
-        {
-            body_result_json["joint_positions"].push_back( {    skeleton.joints[j].position.xyz.x,
-                                                                skeleton.joints[j].position.xyz.y,
-                                                                skeleton.joints[j].position.xyz.z });
+    // Machine-readable per-stage timings are written to this file if it is set
+    std::string StatsPath;
 
-            body_result_json["joint_orientations"].push_back({  skeleton.joints[j].orientation.wxyz.w,
-                                                                skeleton.joints[j].orientation.wxyz.x,
-                                                                skeleton.joints[j].orientation.wxyz.y,
-                                                                skeleton.joints[j].orientation.wxyz.z });
-        }
-        frame_result_json["bodies"].push_back(body_result_json);
-    }
-    frames_json.push_back(frame_result_json);
-    k4abt_frame_release(body_frame);
+    // Batch mode only
+    int WorkerCount = 1;
+    bool ProcessingModeSet = false;
 
-    return true;
+    // Print the progress of a single clip, turned off for the workers of a batch
+    bool PrintProgress = true;
+};
+
+// The mkv format copies the tracks of the recording that is played back by playback_handle
+unique_ptr<ResultWriter> create_result_writer(OutputFormat format, k4a_playback_t playback_handle)
+{
+    switch (format)
+    {
+    case OutputFormat::JsonStream:
+        return make_unique<JsonStreamResultWriter>();
+    case OutputFormat::Binary:
+        return make_unique<BinaryResultWriter>();
+    case OutputFormat::Mkv:
+    {
+        k4a_record_configuration_t record_config;
+        VERIFY(k4a_playback_get_record_configuration(playback_handle, &record_config), "Get record configuration failed!");
+        return make_unique<MkvResultWriter>(record_config);
+    }
+    case OutputFormat::Json:
+    default:
+        return make_unique<JsonDomResultWriter>();
+    }
 }
 
-bool check_depth_image_exists(k4a_capture_t capture)
+// Overlap of a shard with the previous one to warm up its tracker and to match the body ids
+const uint64_t ShardWarmupUsec = 2000000;
+
+// Captures before a checkpoint that are tracked again to warm up the tracker when resuming
+const uint64_t ResumeWarmupUsec = 1000000;
+
+// Checkpoint interval in frames if -resume is given without -checkpoint
+const int DefaultCheckpointInterval = 1000;
+
+const char* get_format_name(OutputFormat format)
 {
-    k4a_image_t depth = k4a_capture_get_depth_image(capture);
-    if (depth != nullptr)
+    switch (format)
     {
-        k4a_image_release(depth);
-        return true;
+    case OutputFormat::JsonStream:
+        return "json_stream";
+    case OutputFormat::Binary:
+        return "binary";
+    case OutputFormat::Mkv:
+        return "mkv";
+    case OutputFormat::Json:
+    default:
+        return "json";
     }
-    else
+}
+
+const char* get_output_extension(OutputFormat format)
+{
+    switch (format)
     {
-        return false;
+    case OutputFormat::Binary:
+        return ".bin";
+    case OutputFormat::Mkv:
+        return ".mkv";
+    default:
+        return ".json";
     }
 }
 
-bool process_mkv_offline(const char* input_path, const char* output_path, k4abt_tracker_configuration_t tracker_config = K4ABT_TRACKER_CONFIG_DEFAULT )
+bool open_recording(const char* input_path, k4abt_tracker_configuration_t tracker_config, k4a_playback_t& playback_handle, k4abt_tracker_t& tracker)
 {
-    k4a_playback_t playback_handle = nullptr;
     k4a_result_t result = k4a_playback_open(input_path, &playback_handle);
     if (result != K4A_RESULT_SUCCEEDED)
     {
@@ -93,93 +133,304 @@ bool process_mkv_offline(const char* input_path, const char* output_path, k4abt_
         return false;
     }
 
+    // Only the depth and IR tracks are needed. Color conversion is never enabled, so the color track is not decoded
+    // and its images are dropped by the TrackingPipeline as soon as they are read.
+    if (!k4a_playback_check_track_exists(playback_handle, "DEPTH"))
+    {
+        cerr << input_path << " has no depth track" << endl;
+        k4a_playback_close(playback_handle);
+        return false;
+    }
+
     k4a_calibration_t calibration;
     result = k4a_playback_get_calibration(playback_handle, &calibration);
     if (result != K4A_RESULT_SUCCEEDED)
     {
         cerr << "Failed to get calibration" << endl;
+        k4a_playback_close(playback_handle);
         return false;
     }
 
-    k4abt_tracker_t tracker = NULL;
     if (K4A_RESULT_SUCCEEDED != k4abt_tracker_create(&calibration, tracker_config, &tracker))
     {
         cerr << "Body tracker initialization failed!" << endl;
+        k4a_playback_close(playback_handle);
         return false;
     }
+    return true;
+}
 
-    json json_output;
-    json_output["k4abt_sdk_version"] = K4ABT_VERSION_STR;
-    json_output["source_file"] = input_path;
+void close_recording(k4a_playback_t playback_handle, k4abt_tracker_t tracker)
+{
+    k4abt_tracker_shutdown(tracker);
+    k4abt_tracker_destroy(tracker);
+    k4a_playback_close(playback_handle);
+}
+
+ClipInfo get_clip_info(const char* input_path, k4a_playback_t playback_handle)
+{
+    ClipInfo clip_info;
+    clip_info.SourceFile = input_path;
 
-    // Store all joint names to the json
-    json_output["joint_names"] = json::array();
-    for (int i = 0; i < (int)K4ABT_JOINT_COUNT; i++)
+    size_t raw_calibration_size = 0;
+    if (k4a_playback_get_raw_calibration(playback_handle, nullptr, &raw_calibration_size) == K4A_BUFFER_RESULT_TOO_SMALL)
     {
-        json_output["joint_names"].push_back(g_jointNames.find((k4abt_joint_id_t)i)->second);
+        clip_info.RawCalibration.resize(raw_calibration_size);
+        if (k4a_playback_get_raw_calibration(playback_handle, clip_info.RawCalibration.data(), &raw_calibration_size) != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            clip_info.RawCalibration.clear();
+        }
     }
+    return clip_info;
+}
 
-    // Store all bone linkings to the json
-    json_output["bone_list"] = json::array();
-    for (int i = 0; i < (int)g_boneList.size(); i++)
+// Tracks one time range of a recording into a temporary binary file
+bool track_shard(const char* input_path, k4abt_tracker_configuration_t tracker_config, const ProcessingOptions& options, const ClipInfo& clip_info, const TrackRange& range, ShardResult& shard, PipelineStats& stats)
+{
+    k4a_playback_t playback_handle = nullptr;
+    k4abt_tracker_t tracker = nullptr;
+    if (!open_recording(input_path, tracker_config, playback_handle, tracker))
     {
-        json_output["bone_list"].push_back({ g_jointNames.find(g_boneList[i].first)->second,
-                                             g_jointNames.find(g_boneList[i].second)->second });
+        return false;
     }
 
-    cout << "Tracking " << input_path << endl;
-
-    int frame_count = 0;
-    json frames_json = json::array();
-    bool success = true;
-    while (true)
+    BinaryResultWriter writer;
+    bool success = writer.Open(shard.Path.c_str(), clip_info);
+    if (success)
     {
-        k4a_capture_t capture_handle = nullptr;
-        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(playback_handle, &capture_handle);
-        if (stream_result == K4A_STREAM_RESULT_EOF)
+        TrackingPipeline pipeline(playback_handle, tracker, writer, options.QueueDepth);
+        pipeline.SetTrackRange(range);
+        pipeline.SetPrintProgress(false);
+        if (options.MotionGateEnabled)
         {
-            break;
+            pipeline.SetMotionGate(options.GateConfig);
         }
+        success = pipeline.Run() && writer.Close();
+        shard.FrameCount = pipeline.GetFrameCount();
+        stats = pipeline.GetStats();
+    }
 
-        cout << "frame " << frame_count << '\r';
-        if (stream_result == K4A_STREAM_RESULT_SUCCEEDED)
+    close_recording(playback_handle, tracker);
+    return success;
+}
+
+// Splits the recording into options.ShardCount time ranges that are tracked in parallel, each by its own tracker.
+// Every range but the first starts ShardWarmupUsec early, so its tracker has settled and the body ids can be matched
+// to the previous range once the range starts.
+bool process_mkv_sharded(const char* input_path, const char* output_path, k4abt_tracker_configuration_t tracker_config, const ProcessingOptions& options, PipelineStats& stats)
+{
+    stats = PipelineStats();
+    auto start_time = chrono::steady_clock::now();
+
+    k4a_playback_t playback_handle = nullptr;
+    if (k4a_playback_open(input_path, &playback_handle) != K4A_RESULT_SUCCEEDED)
+    {
+        cerr << "Cannot open recording at " << input_path << endl;
+        return false;
+    }
+
+    k4a_record_configuration_t record_config;
+    if (k4a_playback_get_record_configuration(playback_handle, &record_config) != K4A_RESULT_SUCCEEDED)
+    {
+        cerr << "Failed to get record configuration" << endl;
+        k4a_playback_close(playback_handle);
+        return false;
+    }
+
+    uint64_t start_usec = record_config.start_timestamp_offset_usec;
+    uint64_t length_usec = k4a_playback_get_recording_length_usec(playback_handle);
+    ClipInfo clip_info = get_clip_info(input_path, playback_handle);
+    k4a_playback_close(playback_handle);
+
+    if (options.PrintProgress)
+    {
+        cout << "Tracking " << input_path << " in " << options.ShardCount << " shards" << endl;
+    }
+
+    int shard_count = options.ShardCount;
+    vector<ShardResult> shards(shard_count);
+    vector<char> shard_succeeded(shard_count, 0);
+    vector<PipelineStats> shard_stats(shard_count);
+    vector<thread> shard_threads;
+    for (int i = 0; i < shard_count; i++)
+    {
+        TrackRange range;
+        range.WriteWarmupFrames = true;
+        if (i > 0)
         {
-            // Only try to predict joints when capture contains depth image
-            if (check_depth_image_exists(capture_handle))
-            {
-                success = predict_joints(frames_json, frame_count, tracker, capture_handle);
-                k4a_capture_release(capture_handle);
-                if (!success)
-                {
-                    cerr << "Predict joints failed for clip at frame " << frame_count << endl;
-                    break;
-                }
-            }
+            range.EmitStartUsec = start_usec + length_usec * i / shard_count;
+            range.WarmupStartUsec = max(start_usec, range.EmitStartUsec - min(ShardWarmupUsec, range.EmitStartUsec));
         }
-        else
+        if (i < shard_count - 1)
         {
-            success = false;
-            cerr << "Stream error for clip at frame " << frame_count << endl;
-            break;
+            range.EndUsec = start_usec + length_usec * (i + 1) / shard_count;
         }
 
-        frame_count++;
+        shards[i].Path = string(output_path) + ".shard" + to_string(i) + ".bin";
+        shard_threads.emplace_back([&, i, range] {
+            shard_succeeded[i] = track_shard(input_path, tracker_config, options, clip_info, range, shards[i], shard_stats[i]);
+        });
+    }
+
+    bool success = true;
+    for (int i = 0; i < shard_count; i++)
+    {
+        shard_threads[i].join();
+        if (!shard_succeeded[i])
+        {
+            cerr << "Tracking shard " << i << " of " << input_path << " failed" << endl;
+            success = false;
+        }
+        stats.Merge(shard_stats[i]);
     }
 
+    // Stitching writes the whole output file, so it is accounted as closing the output
     if (success)
     {
-        json_output["frames"] = frames_json;
-        cout << endl << "DONE " << endl;
+        auto close_start_time = chrono::steady_clock::now();
+        unique_ptr<ResultWriter> writer = create_result_writer(options.Format, nullptr);
+        ShardStitcher stitcher(*writer);
+        success = writer->Open(output_path, clip_info) && stitcher.Stitch(shards) && writer->Close();
+        stats.CloseSeconds += GetElapsedUsec(close_start_time) / 1e6;
+    }
+    stats.ElapsedSeconds = GetElapsedUsec(start_time) / 1e6;
 
-        cout << "Total read " << frame_count << " frames" << endl;
-        std::ofstream output_file(output_path);
-        output_file << std::setw(4) << json_output << std::endl;
+    for (const ShardResult& shard : shards)
+    {
+        remove(shard.Path.c_str());
+    }
+
+    if (success && options.PrintProgress)
+    {
+        cout << endl << "DONE " << endl;
+        cout << "Total read " << stats.FrameCount << " frames" << endl;
         cout << "Results saved in " << output_path;
     }
+    return success;
+}
 
-    k4abt_tracker_shutdown(tracker);
-    k4abt_tracker_destroy(tracker);
-    k4a_playback_close(playback_handle);
+bool process_mkv_offline(const char* input_path, const char* output_path, k4abt_tracker_configuration_t tracker_config, const ProcessingOptions& options, PipelineStats& stats)
+{
+    if (options.ShardCount > 1)
+    {
+        return process_mkv_sharded(input_path, output_path, tracker_config, options, stats);
+    }
+
+    stats = PipelineStats();
+
+    // A checkpoint needs an output file that can be continued. The streaming json writer writes the same json.
+    OutputFormat format = options.Format;
+    bool checkpointing = options.CheckpointInterval > 0;
+    if (checkpointing && format == OutputFormat::Json)
+    {
+        format = OutputFormat::JsonStream;
+    }
+
+    string checkpoint_path = GetCheckpointPath(output_path);
+    Checkpoint checkpoint;
+    bool resuming = options.Resume && LoadCheckpoint(checkpoint_path, checkpoint);
+    if (resuming && (checkpoint.SourceFile != input_path || checkpoint.Format != get_format_name(format)))
+    {
+        cerr << "Checkpoint " << checkpoint_path << " is for " << checkpoint.SourceFile << " in " << checkpoint.Format << " format" << endl;
+        return false;
+    }
+
+    k4a_playback_t playback_handle = nullptr;
+    k4abt_tracker_t tracker = nullptr;
+    if (!open_recording(input_path, tracker_config, playback_handle, tracker))
+    {
+        return false;
+    }
+
+    ClipInfo clip_info = get_clip_info(input_path, playback_handle);
+
+    unique_ptr<ResultWriter> writer = create_result_writer(format, playback_handle);
+    ResumableResultWriter* resumable_writer = nullptr;
+    if (checkpointing)
+    {
+        writer = make_unique<ResumableResultWriter>(move(writer));
+        resumable_writer = static_cast<ResumableResultWriter*>(writer.get());
+    }
+
+    bool opened = false;
+    if (resuming)
+    {
+        opened = resumable_writer->Reopen(output_path, clip_info, checkpoint.Output);
+        resumable_writer->SetResumeState(checkpoint.RecentFrames, checkpoint.NextBodyId);
+    }
+    else
+    {
+        opened = writer->Open(output_path, clip_info);
+    }
+
+    if (!opened)
+    {
+        close_recording(playback_handle, tracker);
+        return false;
+    }
+
+    if (options.PrintProgress)
+    {
+        cout << "Tracking " << input_path << endl;
+    }
+
+    TrackingPipeline pipeline(playback_handle, tracker, *writer, options.QueueDepth);
+    pipeline.SetPrintProgress(options.PrintProgress);
+    if (options.MotionGateEnabled)
+    {
+        pipeline.SetMotionGate(options.GateConfig);
+    }
+
+    if (resuming)
+    {
+        if (options.PrintProgress)
+        {
+            cout << "Resuming at frame " << checkpoint.NextFrameId << endl;
+        }
+
+        TrackRange range;
+        range.EmitStartUsec = checkpoint.LastTimestampUsec + 1;
+        range.WarmupStartUsec = checkpoint.LastTimestampUsec - min(ResumeWarmupUsec, checkpoint.LastTimestampUsec);
+        range.FirstFrameId = checkpoint.NextFrameId;
+        range.WriteWarmupFrames = true;
+        pipeline.SetTrackRange(range);
+    }
+
+    if (checkpointing)
+    {
+        pipeline.SetCheckpointCallback(options.CheckpointInterval, [&](const FrameResult& last_frame) {
+            checkpoint.SourceFile = input_path;
+            checkpoint.Format = get_format_name(format);
+            checkpoint.LastTimestampUsec = last_frame.TimestampUsec;
+            checkpoint.NextFrameId = last_frame.FrameId + 1;
+            checkpoint.RecentFrames.assign(resumable_writer->GetRecentFrames().begin(), resumable_writer->GetRecentFrames().end());
+            checkpoint.NextBodyId = resumable_writer->GetNextBodyId();
+            return writer->Flush(checkpoint.Output) && SaveCheckpoint(checkpoint_path, checkpoint);
+        });
+    }
+
+    bool success = pipeline.Run();
+    stats = pipeline.GetStats();
+
+    if (success)
+    {
+        auto close_start_time = chrono::steady_clock::now();
+        success = writer->Close();
+        stats.CloseSeconds = GetElapsedUsec(close_start_time) / 1e6;
+        stats.ElapsedSeconds += stats.CloseSeconds;
+        if (success && checkpointing)
+        {
+            remove(checkpoint_path.c_str());
+        }
+        if (success && options.PrintProgress)
+        {
+            cout << endl << "DONE " << endl;
+            cout << "Total read " << stats.FrameCount << " frames" << endl;
+            cout << "Results saved in " << output_path;
+        }
+    }
+
+    close_recording(playback_handle, tracker);
 
     return success;
 }
@@ -187,13 +438,25 @@ bool process_mkv_offline(const char* input_path, const char* output_path, k4abt_
 void PrintUsage()
 {
 #ifdef _WIN32
-    cout << "Usage: k4abt_offline_processor.exe <input_mkv_file> <output_json_file> [processing_mode] [-model MODEL_FILE_PATH]\n\t[Optional] processing_mode\n\t\tCPU\n\t\tCUDA\n\t\tTensorRT\n\t\tDirectML ( default )" << endl;
+    cout << "Usage: k4abt_offline_processor.exe <input_mkv_file> <output_json_file> [processing_mode] [-model MODEL_FILE_PATH] [-format FORMAT] [-queue_depth N] [-shard N] [-checkpoint N] [-resume] [-stats FILE] [-motion_gate]\n\t[Optional] processing_mode\n\t\tCPU ( default in batch mode )\n\t\tCUDA\n\t\tTensorRT\n\t\tDirectML ( default )" << endl;
 #else
-    cout << "Usage: k4abt_offline_processor.exe <input_mkv_file> <output_json_file> [processing_mode] [-model MODEL_FILE_PATH]\n\t[Optional] processing_mode\n\t\tCPU\n\t\tCUDA ( default )\n\t\tTensorRT" << endl;
+    cout << "Usage: k4abt_offline_processor.exe <input_mkv_file> <output_json_file> [processing_mode] [-model MODEL_FILE_PATH] [-format FORMAT] [-queue_depth N] [-shard N] [-checkpoint N] [-resume] [-stats FILE] [-motion_gate]\n\t[Optional] processing_mode\n\t\tCPU ( default in batch mode )\n\t\tCUDA ( default )\n\t\tTensorRT" << endl;
 #endif
+    cout << "Batch usage: k4abt_offline_processor.exe <input_directory | manifest.txt> <output_directory> [options] [-workers N]\n\tProcesses every .mkv file of the directory or every recording listed in the manifest, one per line" << endl;
+    cout << "\t[Optional] -format FORMAT\n\t\tjson ( default, whole clip is kept in memory and written at the end )\n\t\tjson_stream ( same json, written frame by frame )\n\t\tbinary ( fixed-size little-endian records with a frame index, see SkeletonBinaryFormat.h )\n\t\tmkv ( new recording with the depth and IR images and the results on custom tracks, see MkvTrackFormat.h )" << endl;
+    cout << "\t[Optional] -queue_depth N\n\t\tNumber of captures kept in flight in the tracker queue ( default 1 )" << endl;
+    cout << "\t[Optional] -shard N\n\t\tSplit every recording into N time ranges that are tracked in parallel and stitched together ( default 1 )" << endl;
+    cout << "\t[Optional] -checkpoint N\n\t\tSave the progress to <output_file>.checkpoint every N frames, json output is written with json_stream" << endl;
+    cout << "\t[Optional] -resume\n\t\tContinue from <output_file>.checkpoint if it exists, checkpoints are saved every " << DefaultCheckpointInterval << " frames unless -checkpoint is given" << endl;
+    cout << "\t[Optional] -motion_gate\n\t\tOnly track the captures whose depth changed against the background, the others keep the bodies of the last tracked capture" << endl;
+    cout << "\t[Optional] -gate_threshold_mm N\n\t\tDepth difference of a changed pixel for -motion_gate ( default " << MotionGateConfig().DepthThresholdMm << " )" << endl;
+    cout << "\t[Optional] -gate_changed_percent P\n\t\tPercentage of changed pixels above which a capture is tracked for -motion_gate ( default " << MotionGateConfig().ChangedPixelPercent << " )" << endl;
+    cout << "\t[Optional] -gate_max_skip N\n\t\tMaximum number of captures in a row that -motion_gate skips ( default " << MotionGateConfig().MaxSkippedFrames << " )" << endl;
+    cout << "\t[Optional] -stats FILE\n\t\tWrite the per-stage timings of the run to a json file" << endl;
+    cout << "\t[Optional] -workers N\n\t\tNumber of clips of a batch that are tracked concurrently ( default 1 )" << endl;
 }
 
-bool ProcessArguments(k4abt_tracker_configuration_t &tracker_config, int argc, char** argv)
+bool ProcessArguments(k4abt_tracker_configuration_t &tracker_config, ProcessingOptions &options, int argc, char** argv)
 {
     if (argc < 3)
     {
@@ -205,19 +468,23 @@ bool ProcessArguments(k4abt_tracker_configuration_t &tracker_config, int argc, c
         if (0 == strcmp(argv[i], "TensorRT"))
         {
             tracker_config.processing_mode = K4ABT_TRACKER_PROCESSING_MODE_GPU_TENSORRT;
+            options.ProcessingModeSet = true;
         }
         else if (0 == strcmp(argv[i], "CUDA"))
         {
             tracker_config.processing_mode = K4ABT_TRACKER_PROCESSING_MODE_GPU_CUDA;
+            options.ProcessingModeSet = true;
         }
         else if (0 == strcmp(argv[i], "CPU"))
         {
             tracker_config.processing_mode = K4ABT_TRACKER_PROCESSING_MODE_CPU;
+            options.ProcessingModeSet = true;
         }
 #ifdef _WIN32
         else if (0 == strcmp(argv[i], "DirectML"))
         {
             tracker_config.processing_mode = K4ABT_TRACKER_PROCESSING_MODE_GPU_DIRECTML;
+            options.ProcessingModeSet = true;
         }
 #endif
         else if (0 == strcmp(argv[i], "-model"))
@@ -231,19 +498,232 @@ bool ProcessArguments(k4abt_tracker_configuration_t &tracker_config, int argc, c
                 return false;
             }
         }
+        else if (0 == strcmp(argv[i], "-format"))
+        {
+            if (i == argc - 1)
+            {
+                printf("Error: output format missing\n");
+                PrintUsage();
+                return false;
+            }
+
+            const char* format = argv[++i];
+            if (0 == strcmp(format, "json"))
+            {
+                options.Format = OutputFormat::Json;
+            }
+            else if (0 == strcmp(format, "json_stream"))
+            {
+                options.Format = OutputFormat::JsonStream;
+            }
+            else if (0 == strcmp(format, "binary"))
+            {
+                options.Format = OutputFormat::Binary;
+            }
+            else if (0 == strcmp(format, "mkv"))
+            {
+                options.Format = OutputFormat::Mkv;
+            }
+            else
+            {
+                printf("Error: unknown output format %s\n", format);
+                PrintUsage();
+                return false;
+            }
+        }
+        else if (0 == strcmp(argv[i], "-queue_depth"))
+        {
+            if (i == argc - 1 || (options.QueueDepth = atoi(argv[++i])) < 1)
+            {
+                printf("Error: queue depth must be a positive number\n");
+                PrintUsage();
+                return false;
+            }
+        }
+        else if (0 == strcmp(argv[i], "-shard"))
+        {
+            if (i == argc - 1 || (options.ShardCount = atoi(argv[++i])) < 1)
+            {
+                printf("Error: number of shards must be a positive number\n");
+                PrintUsage();
+                return false;
+            }
+        }
+        else if (0 == strcmp(argv[i], "-checkpoint"))
+        {
+            if (i == argc - 1 || (options.CheckpointInterval = atoi(argv[++i])) < 1)
+            {
+                printf("Error: checkpoint interval must be a positive number\n");
+                PrintUsage();
+                return false;
+            }
+        }
+        else if (0 == strcmp(argv[i], "-resume"))
+        {
+            options.Resume = true;
+        }
+        else if (0 == strcmp(argv[i], "-motion_gate"))
+        {
+            options.MotionGateEnabled = true;
+        }
+        else if (0 == strcmp(argv[i], "-gate_threshold_mm"))
+        {
+            int threshold = 0;
+            if (i == argc - 1 || (threshold = atoi(argv[++i])) < 1 || threshold > UINT16_MAX)
+            {
+                printf("Error: gate threshold must be a positive number of millimeters\n");
+                PrintUsage();
+                return false;
+            }
+            options.GateConfig.DepthThresholdMm = (uint16_t)threshold;
+            options.MotionGateEnabled = true;
+        }
+        else if (0 == strcmp(argv[i], "-gate_changed_percent"))
+        {
+            if (i == argc - 1 || (options.GateConfig.ChangedPixelPercent = (float)atof(argv[++i])) < 0 ||
+                options.GateConfig.ChangedPixelPercent > 100)
+            {
+                printf("Error: gate changed percent must be between 0 and 100\n");
+                PrintUsage();
+                return false;
+            }
+            options.MotionGateEnabled = true;
+        }
+        else if (0 == strcmp(argv[i], "-gate_max_skip"))
+        {
+            if (i == argc - 1 || (options.GateConfig.MaxSkippedFrames = atoi(argv[++i])) < 0)
+            {
+                printf("Error: gate max skip must not be negative\n");
+                PrintUsage();
+                return false;
+            }
+            options.MotionGateEnabled = true;
+        }
+        else if (0 == strcmp(argv[i], "-stats"))
+        {
+            if (i == argc - 1)
+            {
+                printf("Error: stats filepath missing\n");
+                PrintUsage();
+                return false;
+            }
+            options.StatsPath = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "-workers"))
+        {
+            if (i == argc - 1 || (options.WorkerCount = atoi(argv[++i])) < 1)
+            {
+                printf("Error: number of workers must be a positive number\n");
+                PrintUsage();
+                return false;
+            }
+        }
         else
         {
             PrintUsage();
             return false;
         }
     }
+
+    if (options.Resume && options.CheckpointInterval == 0)
+    {
+        options.CheckpointInterval = DefaultCheckpointInterval;
+    }
+    if (options.Format == OutputFormat::Mkv && (options.CheckpointInterval > 0 || options.ShardCount > 1))
+    {
+        printf("Error: mkv output is not supported together with -checkpoint, -resume or -shard\n");
+        PrintUsage();
+        return false;
+    }
+    if (options.CheckpointInterval > 0 && options.ShardCount > 1)
+    {
+        printf("Error: checkpoints are not supported together with -shard\n");
+        PrintUsage();
+        return false;
+    }
+    return true;
+}
+
+bool is_batch_input(const char* input)
+{
+    string input_path = input;
+    if (input_path.size() >= 4 && 0 == input_path.compare(input_path.size() - 4, 4, ".txt"))
+    {
+        return true;
+    }
+    return filesystem::is_directory(input_path);
+}
+
+bool process_batch_offline(const char* input, const char* output_directory, k4abt_tracker_configuration_t tracker_config, ProcessingOptions options, PipelineStats& stats)
+{
+    vector<ClipJob> jobs;
+    if (!CollectClipJobs(input, output_directory, get_output_extension(options.Format), jobs))
+    {
+        return false;
+    }
+
+    // Several trackers run side by side in batch mode, so they run on the CPU unless a processing mode is given
+    if (!options.ProcessingModeSet)
+    {
+        tracker_config.processing_mode = K4ABT_TRACKER_PROCESSING_MODE_CPU;
+    }
+    options.PrintProgress = false;
+
+    // Every clip needs its own tracker since a tracker is created for the calibration of the recording
+    BatchProcessor batch(options.WorkerCount, [&](const ClipJob& job, PipelineStats& clip_stats) {
+        return process_mkv_offline(job.InputPath.c_str(), job.OutputPath.c_str(), tracker_config, options, clip_stats);
+    });
+    return batch.Run(move(jobs), stats);
+}
+
+bool write_stats_file(const string& stats_path, const char* input, k4abt_tracker_configuration_t tracker_config, const ProcessingOptions& options, const PipelineStats& stats, bool succeeded)
+{
+    nlohmann::json stats_json = stats.ToJson();
+    stats_json["k4abt_sdk_version"] = K4ABT_VERSION_STR;
+    stats_json["input"] = input;
+    stats_json["model"] = tracker_config.model_path != nullptr ? tracker_config.model_path : "";
+    stats_json["processing_mode"] = (int)tracker_config.processing_mode;
+    stats_json["queue_depth"] = options.QueueDepth;
+    stats_json["shards"] = options.ShardCount;
+    stats_json["workers"] = options.WorkerCount;
+    if (options.MotionGateEnabled)
+    {
+        stats_json["motion_gate"]["threshold_mm"] = options.GateConfig.DepthThresholdMm;
+        stats_json["motion_gate"]["changed_percent"] = options.GateConfig.ChangedPixelPercent;
+        stats_json["motion_gate"]["max_skip"] = options.GateConfig.MaxSkippedFrames;
+    }
+    stats_json["succeeded"] = succeeded;
+
+    std::ofstream stats_file(stats_path);
+    stats_file << std::setw(4) << stats_json << std::endl;
+    if (!stats_file.good())
+    {
+        cerr << "Failed to write stats to " << stats_path << endl;
+        return false;
+    }
     return true;
 }
 
 int main(int argc, char **argv)
 {
     k4abt_tracker_configuration_t tracker_config = K4ABT_TRACKER_CONFIG_DEFAULT;
-    if (!ProcessArguments(tracker_config, argc, argv))
+    ProcessingOptions options;
+    if (!ProcessArguments(tracker_config, options, argc, argv))
         return -1;
-    return process_mkv_offline(argv[1], argv[2], tracker_config) ? 0 : -1;
+
+    bool batch = is_batch_input(argv[1]);
+    PipelineStats stats;
+    bool success = batch ? process_batch_offline(argv[1], argv[2], tracker_config, options, stats)
+                         : process_mkv_offline(argv[1], argv[2], tracker_config, options, stats);
+
+    if (stats.FrameCount > 0)
+    {
+        cout << endl << endl;
+        stats.Print(cout);
+    }
+    if (!options.StatsPath.empty())
+    {
+        success = write_stats_file(options.StatsPath, argv[1], tracker_config, options, stats, success) && success;
+    }
+    return success ? 0 : -1;
 }
@@ -0,0 +1,607 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <k4a/k4a.h>
+
+#include "PointCloudBuffer.h"
+#include "SimdSupport.h"
+#include "ThreadPool.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Samples
+{
+    // Row kernels of DepthUnprojector. Every kernel converts pixelCount depth pixels, step pixels apart, with the table
+    // entries of the same pixels, writes the valid points compacted and returns their count. No more than room points
+    // are written, and no entry past room is touched, so rows of different threads can be written next to each other.
+    namespace DepthUnprojectorKernels
+    {
+        // Table entries of a depth pixel: point = depth * (X, Y, Scale), in meters. Scale is 0 for the pixels that
+        // have no valid unprojection, so their points have a z of 0 like the pixels without depth.
+        struct Tables
+        {
+            const float* X;
+            const float* Y;
+            const float* Scale;
+        };
+
+        inline size_t UnprojectRowScalar(const uint16_t* depth, const Tables& tables, int pixelCount, int step,
+            const k4a_float3_t& up, k4a_float3_t* points, float* elevations, size_t room)
+        {
+            size_t count = 0;
+            for (int i = 0; i < pixelCount && count < room; ++i)
+            {
+                const size_t p = static_cast<size_t>(i) * step;
+                const float d = static_cast<float>(depth[p]);
+                const float z = d * tables.Scale[p];
+                if (z > 0)
+                {
+                    const float x = d * tables.X[p];
+                    const float y = d * tables.Y[p];
+                    points[count] = { { x, y, z } };
+                    if (elevations != nullptr)
+                    {
+                        // Same order as Vector::Dot().
+                        elevations[count] = up.xyz.x * x + up.xyz.y * y + up.xyz.z * z;
+                    }
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        // Same as UnprojectRowScalar() for separate x, y, z arrays. pixelIndex is the index of the first pixel.
+        inline size_t UnprojectRowArraysScalar(const uint16_t* depth, const Tables& tables, int pixelCount, int step,
+            uint32_t pixelIndex, float* xs, float* ys, float* zs, uint32_t* pixelIndices, size_t room)
+        {
+            size_t count = 0;
+            for (int i = 0; i < pixelCount && count < room; ++i)
+            {
+                const size_t p = static_cast<size_t>(i) * step;
+                const float d = static_cast<float>(depth[p]);
+                const float z = d * tables.Scale[p];
+                if (z > 0)
+                {
+                    xs[count] = d * tables.X[p];
+                    ys[count] = d * tables.Y[p];
+                    zs[count] = z;
+                    if (pixelIndices != nullptr)
+                    {
+                        pixelIndices[count] = pixelIndex + static_cast<uint32_t>(p);
+                    }
+                    count++;
+                }
+            }
+            return count;
+        }
+
+#ifdef SAMPLES_X86_SIMD
+        // The SIMD kernels do the same multiplications as the scalar ones, without FMA, so their results are
+        // identical. The points kernels write every lane to the next free slot, which only advances for valid lanes,
+        // the arrays kernels move the valid lanes to the front with one shuffle and store all the lanes. Either way a
+        // group of lanes is only converted while room is left for all of them.
+
+        struct CompactionTables
+        {
+            // Byte shuffles of 4 x 32-bit lanes for _mm_shuffle_epi8().
+            uint8_t Shuffle4[16][16];
+
+            // Lane permutations of 8 x 32-bit lanes for _mm256_permutevar8x32_ps().
+            int32_t Permute8[256][8];
+
+            // Number of valid lanes of every mask.
+            uint8_t ValidCount[256];
+
+            CompactionTables()
+            {
+                for (int mask = 0; mask < 256; ++mask)
+                {
+                    int valid = 0;
+                    for (int lane = 0; lane < 8; ++lane)
+                    {
+                        if ((mask >> lane) & 1)
+                        {
+                            Permute8[mask][valid++] = lane;
+                        }
+                    }
+                    for (int lane = valid; lane < 8; ++lane)
+                    {
+                        Permute8[mask][lane] = 0;
+                    }
+                    ValidCount[mask] = static_cast<uint8_t>(valid);
+
+                    if (mask < 16)
+                    {
+                        for (int lane = 0; lane < 4; ++lane)
+                        {
+                            for (int byte = 0; byte < 4; ++byte)
+                            {
+                                Shuffle4[mask][lane * 4 + byte] = static_cast<uint8_t>(Permute8[mask][lane] * 4 + byte);
+                            }
+                        }
+                    }
+                }
+            }
+        };
+
+        inline const CompactionTables& GetCompactionTables()
+        {
+            static const CompactionTables tables;
+            return tables;
+        }
+
+        // Loads the depth and the table entries of 4 pixels, starting at pixel i.
+        SAMPLES_TARGET_SSE41
+        inline void LoadLanesSse41(const uint16_t* depth, const Tables& tables, int i, int step, __m128& d, __m128& tx, __m128& ty, __m128& ts)
+        {
+            if (step == 1)
+            {
+                d = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(depth + i))));
+                tx = _mm_loadu_ps(tables.X + i);
+                ty = _mm_loadu_ps(tables.Y + i);
+                ts = _mm_loadu_ps(tables.Scale + i);
+                return;
+            }
+
+            const size_t p0 = static_cast<size_t>(i) * step;
+            const size_t p1 = p0 + step;
+            const size_t p2 = p1 + step;
+            const size_t p3 = p2 + step;
+            d = _mm_cvtepi32_ps(_mm_setr_epi32(depth[p0], depth[p1], depth[p2], depth[p3]));
+            tx = _mm_setr_ps(tables.X[p0], tables.X[p1], tables.X[p2], tables.X[p3]);
+            ty = _mm_setr_ps(tables.Y[p0], tables.Y[p1], tables.Y[p2], tables.Y[p3]);
+            ts = _mm_setr_ps(tables.Scale[p0], tables.Scale[p1], tables.Scale[p2], tables.Scale[p3]);
+        }
+
+        // Loads the depth and the table entries of 8 pixels, starting at pixel i.
+        SAMPLES_TARGET_AVX2
+        inline void LoadLanesAvx2(const uint16_t* depth, const Tables& tables, int i, int step, __m256& d, __m256& tx, __m256& ty, __m256& ts)
+        {
+            if (step == 1)
+            {
+                d = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i))));
+                tx = _mm256_loadu_ps(tables.X + i);
+                ty = _mm256_loadu_ps(tables.Y + i);
+                ts = _mm256_loadu_ps(tables.Scale + i);
+                return;
+            }
+
+            // The 16-bit depth is not gathered, a 32-bit gather could read past the end of the image.
+            const size_t p = static_cast<size_t>(i) * step;
+            const uint16_t* row = depth + p;
+            d = _mm256_cvtepi32_ps(_mm256_setr_epi32(row[0], row[step], row[2 * step], row[3 * step],
+                row[4 * step], row[5 * step], row[6 * step], row[7 * step]));
+
+            const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(step));
+            tx = _mm256_i32gather_ps(tables.X + p, offsets, 4);
+            ty = _mm256_i32gather_ps(tables.Y + p, offsets, 4);
+            ts = _mm256_i32gather_ps(tables.Scale + p, offsets, 4);
+        }
+
+        SAMPLES_TARGET_SSE41
+        inline size_t UnprojectRowSse41(const uint16_t* depth, const Tables& tables, int pixelCount, int step,
+            const k4a_float3_t& up, k4a_float3_t* points, float* elevations, size_t room)
+        {
+            const __m128 upX = _mm_set1_ps(up.xyz.x);
+            const __m128 upY = _mm_set1_ps(up.xyz.y);
+            const __m128 upZ = _mm_set1_ps(up.xyz.z);
+
+            size_t count = 0;
+            int i = 0;
+            for (; i + 4 <= pixelCount && count + 4 <= room; i += 4)
+            {
+                __m128 d, tx, ty, ts;
+                LoadLanesSse41(depth, tables, i, step, d, tx, ty, ts);
+
+                __m128 z = _mm_mul_ps(d, ts);
+                int validMask = _mm_movemask_ps(_mm_cmpgt_ps(z, _mm_setzero_ps()));
+                if (validMask == 0)
+                {
+                    continue;
+                }
+
+                __m128 x = _mm_mul_ps(d, tx);
+                __m128 y = _mm_mul_ps(d, ty);
+                __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(upX, x), _mm_mul_ps(upY, y)), _mm_mul_ps(upZ, z));
+
+                alignas(16) float xs[4], ys[4], zs[4], es[4];
+                _mm_store_ps(xs, x);
+                _mm_store_ps(ys, y);
+                _mm_store_ps(zs, z);
+                _mm_store_ps(es, e);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    points[count] = { { xs[lane], ys[lane], zs[lane] } };
+                    if (elevations != nullptr)
+                    {
+                        elevations[count] = es[lane];
+                    }
+                    count += (validMask >> lane) & 1;
+                }
+            }
+
+            const size_t p = static_cast<size_t>(i) * step;
+            return count + UnprojectRowScalar(depth + p, { tables.X + p, tables.Y + p, tables.Scale + p }, pixelCount - i, step,
+                up, points + count, elevations != nullptr ? elevations + count : nullptr, room - count);
+        }
+
+        SAMPLES_TARGET_AVX2
+        inline size_t UnprojectRowAvx2(const uint16_t* depth, const Tables& tables, int pixelCount, int step,
+            const k4a_float3_t& up, k4a_float3_t* points, float* elevations, size_t room)
+        {
+            const __m256 upX = _mm256_set1_ps(up.xyz.x);
+            const __m256 upY = _mm256_set1_ps(up.xyz.y);
+            const __m256 upZ = _mm256_set1_ps(up.xyz.z);
+
+            size_t count = 0;
+            int i = 0;
+            for (; i + 8 <= pixelCount && count + 8 <= room; i += 8)
+            {
+                __m256 d, tx, ty, ts;
+                LoadLanesAvx2(depth, tables, i, step, d, tx, ty, ts);
+
+                __m256 z = _mm256_mul_ps(d, ts);
+                int validMask = _mm256_movemask_ps(_mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_GT_OQ));
+                if (validMask == 0)
+                {
+                    continue;
+                }
+
+                // No FMA, to keep the rounding of the scalar kernel.
+                __m256 x = _mm256_mul_ps(d, tx);
+                __m256 y = _mm256_mul_ps(d, ty);
+                __m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(upX, x), _mm256_mul_ps(upY, y)), _mm256_mul_ps(upZ, z));
+
+                alignas(32) float xs[8], ys[8], zs[8], es[8];
+                _mm256_store_ps(xs, x);
+                _mm256_store_ps(ys, y);
+                _mm256_store_ps(zs, z);
+                _mm256_store_ps(es, e);
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    points[count] = { { xs[lane], ys[lane], zs[lane] } };
+                    if (elevations != nullptr)
+                    {
+                        elevations[count] = es[lane];
+                    }
+                    count += (validMask >> lane) & 1;
+                }
+            }
+
+            const size_t p = static_cast<size_t>(i) * step;
+            return count + UnprojectRowScalar(depth + p, { tables.X + p, tables.Y + p, tables.Scale + p }, pixelCount - i, step,
+                up, points + count, elevations != nullptr ? elevations + count : nullptr, room - count);
+        }
+
+        SAMPLES_TARGET_SSE41
+        inline size_t UnprojectRowArraysSse41(const uint16_t* depth, const Tables& tables, int pixelCount, int step,
+            uint32_t pixelIndex, float* xs, float* ys, float* zs, uint32_t* pixelIndices, size_t room)
+        {
+            const CompactionTables& compaction = GetCompactionTables();
+            const __m128i laneSteps = _mm_setr_epi32(0, step, 2 * step, 3 * step);
+
+            size_t count = 0;
+            int i = 0;
+            for (; i + 4 <= pixelCount && count + 4 <= room; i += 4)
+            {
+                __m128 d, tx, ty, ts;
+                LoadLanesSse41(depth, tables, i, step, d, tx, ty, ts);
+
+                __m128 z = _mm_mul_ps(d, ts);
+                int validMask = _mm_movemask_ps(_mm_cmpgt_ps(z, _mm_setzero_ps()));
+                if (validMask == 0)
+                {
+                    continue;
+                }
+
+                __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(compaction.Shuffle4[validMask]));
+                __m128i x = _mm_castps_si128(_mm_mul_ps(d, tx));
+                __m128i y = _mm_castps_si128(_mm_mul_ps(d, ty));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(xs + count), _mm_shuffle_epi8(x, shuffle));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(ys + count), _mm_shuffle_epi8(y, shuffle));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(zs + count), _mm_shuffle_epi8(_mm_castps_si128(z), shuffle));
+                if (pixelIndices != nullptr)
+                {
+                    __m128i indices = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(pixelIndex + i * step)), laneSteps);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixelIndices + count), _mm_shuffle_epi8(indices, shuffle));
+                }
+                count += compaction.ValidCount[validMask];
+            }
+
+            const size_t p = static_cast<size_t>(i) * step;
+            return count + UnprojectRowArraysScalar(depth + p, { tables.X + p, tables.Y + p, tables.Scale + p }, pixelCount - i, step,
+                pixelIndex + static_cast<uint32_t>(p), xs + count, ys + count, zs + count,
+                pixelIndices != nullptr ? pixelIndices + count : nullptr, room - count);
+        }
+
+        SAMPLES_TARGET_AVX2
+        inline size_t UnprojectRowArraysAvx2(const uint16_t* depth, const Tables& tables, int pixelCount, int step,
+            uint32_t pixelIndex, float* xs, float* ys, float* zs, uint32_t* pixelIndices, size_t room)
+        {
+            const CompactionTables& compaction = GetCompactionTables();
+            const __m256i laneSteps = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(step));
+
+            size_t count = 0;
+            int i = 0;
+            for (; i + 8 <= pixelCount && count + 8 <= room; i += 8)
+            {
+                __m256 d, tx, ty, ts;
+                LoadLanesAvx2(depth, tables, i, step, d, tx, ty, ts);
+
+                __m256 z = _mm256_mul_ps(d, ts);
+                int validMask = _mm256_movemask_ps(_mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_GT_OQ));
+                if (validMask == 0)
+                {
+                    continue;
+                }
+
+                __m256i permutation = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(compaction.Permute8[validMask]));
+                _mm256_storeu_ps(xs + count, _mm256_permutevar8x32_ps(_mm256_mul_ps(d, tx), permutation));
+                _mm256_storeu_ps(ys + count, _mm256_permutevar8x32_ps(_mm256_mul_ps(d, ty), permutation));
+                _mm256_storeu_ps(zs + count, _mm256_permutevar8x32_ps(z, permutation));
+                if (pixelIndices != nullptr)
+                {
+                    __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(pixelIndex + i * step)), laneSteps);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixelIndices + count), _mm256_permutevar8x32_epi32(indices, permutation));
+                }
+                count += compaction.ValidCount[validMask];
+            }
+
+            const size_t p = static_cast<size_t>(i) * step;
+            return count + UnprojectRowArraysScalar(depth + p, { tables.X + p, tables.Y + p, tables.Scale + p }, pixelCount - i, step,
+                pixelIndex + static_cast<uint32_t>(p), xs + count, ys + count, zs + count,
+                pixelIndices != nullptr ? pixelIndices + count : nullptr, room - count);
+        }
+#endif
+    }
+
+    // Converts depth images to points in meters with a table of the unprojected direction of every depth pixel, which
+    // is computed once from the calibration. Every point is the depth times its table entry, so the float points are
+    // written directly, without the int16 point cloud image of k4a_transformation_depth_image_to_point_cloud() and its
+    // conversion to meters. The conversion uses SIMD, and the threads of a ThreadPool for large images.
+    //
+    // Depth images are DEPTH16 images of the calibrated depth mode, rows of GetWidth() pixels.
+    class DepthUnprojector
+    {
+    public:
+        explicit DepthUnprojector(const k4a_calibration_t& sensorCalibration)
+            : m_width(sensorCalibration.depth_camera_calibration.resolution_width)
+            , m_height(sensorCalibration.depth_camera_calibration.resolution_height)
+        {
+            const float MillimeterToMeter = 0.001f;
+            const size_t pixelCount = static_cast<size_t>(m_width) * m_height;
+            m_xyTable.resize(pixelCount);
+            m_tableX.resize(pixelCount);
+            m_tableY.resize(pixelCount);
+            m_tableScale.resize(pixelCount);
+
+            size_t pixelIndex = 0;
+            for (int h = 0; h < m_height; h++)
+            {
+                for (int w = 0; w < m_width; w++, pixelIndex++)
+                {
+                    k4a_float2_t pixel = { { static_cast<float>(w), static_cast<float>(h) } };
+                    k4a_float3_t direction;
+                    int valid = 0;
+                    VERIFY(k4a_calibration_2d_to_3d(&sensorCalibration,
+                        &pixel,
+                        1.f,
+                        K4A_CALIBRATION_TYPE_DEPTH,
+                        K4A_CALIBRATION_TYPE_DEPTH,
+                        &direction,
+                        &valid), "Create depth unprojection table failed!");
+
+                    // Pixels without a valid unprojection get a scale of 0, their points are invalid like the ones
+                    // without depth.
+                    if (valid == 0)
+                    {
+                        m_xyTable[pixelIndex] = { { 0.f, 0.f } };
+                        m_tableX[pixelIndex] = 0.f;
+                        m_tableY[pixelIndex] = 0.f;
+                        m_tableScale[pixelIndex] = 0.f;
+                    }
+                    else
+                    {
+                        m_xyTable[pixelIndex] = { { direction.xyz.x, direction.xyz.y } };
+                        m_tableX[pixelIndex] = direction.xyz.x * MillimeterToMeter;
+                        m_tableY[pixelIndex] = direction.xyz.y * MillimeterToMeter;
+                        m_tableScale[pixelIndex] = MillimeterToMeter;
+                    }
+                }
+            }
+        }
+
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+
+        // Point of every depth pixel at a depth of 1, row by row, (0, 0) for the pixels without a valid unprojection.
+        const std::vector<k4a_float2_t>& GetXyTable() const { return m_xyTable; }
+
+        // Instruction set of the conversion, the best one supported by default.
+        void SetSimdLevel(SimdLevel level) { m_simdLevel = level; }
+
+        // Splits the conversions of at least minimumPixelCount sampled pixels across the threads of pool, nullptr to
+        // convert on the calling thread only. The points are the same, in the same order, either way.
+        void SetThreadPool(ThreadPool* pool, size_t minimumPixelCount = 100000)
+        {
+            m_threadPool = pool;
+            m_minimumParallelPixelCount = minimumPixelCount;
+        }
+
+        // region with its size filled in and clipped to the image.
+        PointCloudRegion ClipRegion(const PointCloudRegion& region) const
+        {
+            PointCloudRegion clipped = region;
+            clipped.X = std::min(std::max(region.X, 0), m_width);
+            clipped.Y = std::min(std::max(region.Y, 0), m_height);
+            clipped.Width = std::min(region.Width > 0 ? region.X + region.Width : m_width, m_width) - clipped.X;
+            clipped.Height = std::min(region.Height > 0 ? region.Y + region.Height : m_height, m_height) - clipped.Y;
+            clipped.Width = std::max(clipped.Width, 0);
+            clipped.Height = std::max(clipped.Height, 0);
+            clipped.StepX = std::max(region.StepX, 1);
+            clipped.StepY = std::max(region.StepY, 1);
+            return clipped;
+        }
+
+        // Most points a conversion of region can return, the number of sampled pixels in region.
+        size_t GetMaxPointCount(const PointCloudRegion& region) const
+        {
+            PointCloudRegion clipped = ClipRegion(region);
+            return GetPixelsPerRow(clipped) * GetRowCount(clipped);
+        }
+
+        // Writes the valid points of region to the arrays of points, with their pixel index when points.PixelIndices
+        // is set, and returns their count. The points are in pixel order, only the first points.Capacity are written.
+        size_t Unproject(const uint16_t* depth, const PointCloudRegion& region, const PointCloudArrays& points) const
+        {
+            using namespace DepthUnprojectorKernels;
+            auto unprojectRow = UnprojectRowArraysScalar;
+#ifdef SAMPLES_X86_SIMD
+            if (m_simdLevel == SimdLevel::Avx2)
+            {
+                unprojectRow = UnprojectRowArraysAvx2;
+            }
+            else if (m_simdLevel == SimdLevel::Sse41)
+            {
+                unprojectRow = UnprojectRowArraysSse41;
+            }
+#endif
+
+            const PointCloudRegion clipped = ClipRegion(region);
+            const int pixelsPerRow = static_cast<int>(GetPixelsPerRow(clipped));
+            return UnprojectRows(depth, clipped, points.Capacity, [&](int row, size_t offset, size_t room) {
+                const size_t first = static_cast<size_t>(row) * m_width + clipped.X;
+                return unprojectRow(depth + first, GetTables(first), pixelsPerRow, clipped.StepX, static_cast<uint32_t>(first),
+                    points.X + offset, points.Y + offset, points.Z + offset,
+                    points.PixelIndices != nullptr ? points.PixelIndices + offset : nullptr, room);
+            });
+        }
+
+        // Writes the valid points of region to points, which has room for capacity points, and returns their count.
+        // The points are in pixel order, only the first capacity points are written.
+        size_t Unproject(const uint16_t* depth, const PointCloudRegion& region, k4a_float3_t* points, size_t capacity) const
+        {
+            return UnprojectPoints(depth, region, { { 0.f, 0.f, 0.f } }, points, nullptr, capacity);
+        }
+
+        // Same as above, and writes the elevation of every point along up, up.Dot(point), to elevations.
+        size_t Unproject(const uint16_t* depth, const PointCloudRegion& region, const k4a_float3_t& up,
+            k4a_float3_t* points, float* elevations, size_t capacity) const
+        {
+            return UnprojectPoints(depth, region, up, points, elevations, capacity);
+        }
+
+    private:
+        static size_t GetPixelsPerRow(const PointCloudRegion& clipped)
+        {
+            return static_cast<size_t>((clipped.Width + clipped.StepX - 1) / clipped.StepX);
+        }
+
+        static size_t GetRowCount(const PointCloudRegion& clipped)
+        {
+            return static_cast<size_t>((clipped.Height + clipped.StepY - 1) / clipped.StepY);
+        }
+
+        DepthUnprojectorKernels::Tables GetTables(size_t pixelIndex) const
+        {
+            return { m_tableX.data() + pixelIndex, m_tableY.data() + pixelIndex, m_tableScale.data() + pixelIndex };
+        }
+
+        size_t UnprojectPoints(const uint16_t* depth, const PointCloudRegion& region, const k4a_float3_t& up,
+            k4a_float3_t* points, float* elevations, size_t capacity) const
+        {
+            using namespace DepthUnprojectorKernels;
+            auto unprojectRow = UnprojectRowScalar;
+#ifdef SAMPLES_X86_SIMD
+            if (m_simdLevel == SimdLevel::Avx2)
+            {
+                unprojectRow = UnprojectRowAvx2;
+            }
+            else if (m_simdLevel == SimdLevel::Sse41)
+            {
+                unprojectRow = UnprojectRowSse41;
+            }
+#endif
+
+            const PointCloudRegion clipped = ClipRegion(region);
+            const int pixelsPerRow = static_cast<int>(GetPixelsPerRow(clipped));
+            return UnprojectRows(depth, clipped, capacity, [&](int row, size_t offset, size_t room) {
+                const size_t first = static_cast<size_t>(row) * m_width + clipped.X;
+                return unprojectRow(depth + first, GetTables(first), pixelsPerRow, clipped.StepX,
+                    up, points + offset, elevations != nullptr ? elevations + offset : nullptr, room);
+            });
+        }
+
+        // Calls unprojectRow(row, offset, room) for the sampled rows of clipped, which writes the points of row
+        // starting at entry offset, at most room of them, and returns their count. Returns the total count.
+        template <typename UnprojectRow>
+        size_t UnprojectRows(const uint16_t* depth, const PointCloudRegion& clipped, size_t capacity, const UnprojectRow& unprojectRow) const
+        {
+            const size_t rowCount = GetRowCount(clipped);
+            const size_t pixelsPerRow = GetPixelsPerRow(clipped);
+            if (m_threadPool == nullptr || m_threadPool->GetThreadCount() == 1 || rowCount < 2 ||
+                rowCount * pixelsPerRow < m_minimumParallelPixelCount)
+            {
+                size_t count = 0;
+                for (size_t r = 0; r < rowCount && count < capacity; ++r)
+                {
+                    count += unprojectRow(clipped.Y + static_cast<int>(r) * clipped.StepY, count, capacity - count);
+                }
+                return count;
+            }
+
+            // The valid pixels of every chunk of rows are counted first, so every chunk can write its points at their
+            // final position and the points are in the same order as on a single thread. A few chunks per thread
+            // even out the work of rows with more valid pixels.
+            const size_t chunkCount = std::min(rowCount, m_threadPool->GetThreadCount() * 4);
+            auto getChunkRow = [&](size_t chunk) { return chunk * rowCount / chunkCount; };
+
+            std::vector<size_t> offsets(chunkCount + 1, 0);
+            m_threadPool->Run(chunkCount, [&](size_t chunk) {
+                size_t validCount = 0;
+                for (size_t r = getChunkRow(chunk); r < getChunkRow(chunk + 1); ++r)
+                {
+                    const size_t first = (clipped.Y + r * clipped.StepY) * m_width + clipped.X;
+                    for (size_t i = 0; i < pixelsPerRow; ++i)
+                    {
+                        const size_t p = first + i * clipped.StepX;
+                        validCount += depth[p] != 0 && m_tableScale[p] > 0;
+                    }
+                }
+                offsets[chunk + 1] = validCount;
+            });
+
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                offsets[chunk + 1] += offsets[chunk];
+            }
+
+            m_threadPool->Run(chunkCount, [&](size_t chunk) {
+                size_t offset = std::min(offsets[chunk], capacity);
+                const size_t end = std::min(offsets[chunk + 1], capacity);
+                for (size_t r = getChunkRow(chunk); r < getChunkRow(chunk + 1) && offset < end; ++r)
+                {
+                    offset += unprojectRow(clipped.Y + static_cast<int>(r) * clipped.StepY, offset, end - offset);
+                }
+            });
+            return std::min(offsets[chunkCount], capacity);
+        }
+
+        int m_width = 0;
+        int m_height = 0;
+        std::vector<k4a_float2_t> m_xyTable;
+        std::vector<float> m_tableX;
+        std::vector<float> m_tableY;
+        std::vector<float> m_tableScale;
+
+        SimdLevel m_simdLevel = GetSupportedSimdLevel();
+        ThreadPool* m_threadPool = nullptr;
+        size_t m_minimumParallelPixelCount = 100000;
+    };
+}
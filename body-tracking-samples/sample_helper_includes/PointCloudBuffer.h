@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace Samples
+{
+    // Part of the depth image that is converted to points, and the sampling steps within it. A Width or Height of 0
+    // extends the region to the edge of the image.
+    struct PointCloudRegion
+    {
+        int X = 0;
+        int Y = 0;
+        int Width = 0;
+        int Height = 0;
+        int StepX = 1;
+        int StepY = 1;
+    };
+
+    // Structure of arrays output of DepthUnprojector::Unproject(depth, region, arrays). The arrays belong to the
+    // caller and have room for Capacity entries each. PixelIndices is optional, when set it receives the index of the
+    // depth pixel of every point (row * image width + column).
+    struct PointCloudArrays
+    {
+        float* X = nullptr;
+        float* Y = nullptr;
+        float* Z = nullptr;
+        uint32_t* PixelIndices = nullptr;
+        size_t Capacity = 0;
+    };
+
+    // Allocates the arrays of a PointCloudArrays once, in a single block, each one starting on a cache line, so
+    // SIMD code can use aligned loads from the start of every array.
+    class AlignedPointCloudBuffer
+    {
+    public:
+        static constexpr size_t Alignment = 64;
+
+        AlignedPointCloudBuffer(size_t capacity, bool withPixelIndices)
+        {
+            // Every array is padded to a whole number of cache lines.
+            const size_t entriesPerLine = Alignment / sizeof(float);
+            const size_t arrayCapacity = (capacity + entriesPerLine - 1) / entriesPerLine * entriesPerLine;
+            const size_t arrayCount = withPixelIndices ? 4 : 3;
+            static_assert(sizeof(float) == sizeof(uint32_t), "All arrays have the same entry size");
+
+            m_memory.reset(::operator new(arrayCount * arrayCapacity * sizeof(float), std::align_val_t(Alignment)));
+            float* memory = static_cast<float*>(m_memory.get());
+            m_arrays.X = memory;
+            m_arrays.Y = memory + arrayCapacity;
+            m_arrays.Z = memory + 2 * arrayCapacity;
+            m_arrays.PixelIndices = withPixelIndices ? reinterpret_cast<uint32_t*>(memory + 3 * arrayCapacity) : nullptr;
+            m_arrays.Capacity = capacity;
+        }
+
+        const PointCloudArrays& GetArrays() const { return m_arrays; }
+
+    private:
+        struct AlignedDelete
+        {
+            void operator()(void* memory) const
+            {
+                ::operator delete(memory, std::align_val_t(Alignment));
+            }
+        };
+
+        std::unique_ptr<void, AlignedDelete> m_memory;
+        PointCloudArrays m_arrays;
+    };
+}
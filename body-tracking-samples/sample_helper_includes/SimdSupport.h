@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SAMPLES_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>     // __cpuid, _xgetbv
+#endif
+#endif
+
+// SIMD kernels are compiled for their instruction set even if the rest of the project is not, they are only called
+// after checking that the processor supports them.
+#if defined(__GNUC__) || defined(__clang__)
+#define SAMPLES_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SAMPLES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SAMPLES_TARGET_SSE41
+#define SAMPLES_TARGET_AVX2
+#endif
+
+namespace Samples
+{
+    // Instruction sets the point cloud kernels can use, in increasing order.
+    enum class SimdLevel
+    {
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
+    // Highest instruction set that is supported by the processor and the compiler.
+    inline SimdLevel GetSupportedSimdLevel()
+    {
+#if defined(SAMPLES_X86_SIMD) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+
+        // AVX registers must also be saved by the operating system.
+        if (avx2 && avx && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            return SimdLevel::Avx2;
+        }
+        return sse41 ? SimdLevel::Sse41 : SimdLevel::Scalar;
+#elif defined(SAMPLES_X86_SIMD)
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SimdLevel::Avx2;
+        }
+        return __builtin_cpu_supports("sse4.1") ? SimdLevel::Sse41 : SimdLevel::Scalar;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    inline const char* GetSimdLevelName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Avx2:
+            return "avx2";
+        case SimdLevel::Sse41:
+            return "sse4.1";
+        default:
+            return "scalar";
+        }
+    }
+}
@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Samples
+{
+    // Fixed set of worker threads for data parallel loops. The threads are created once and wait between loops, so
+    // a loop can be split across them every frame.
+    class ThreadPool
+    {
+    public:
+        // The calling thread of Run() is one of the threadCount threads.
+        explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency())
+        {
+            // hardware_concurrency() returns 0 when it is not known.
+            threadCount = std::max<size_t>(threadCount, 1);
+            for (size_t i = 1; i < threadCount; ++i)
+            {
+                m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_isStopping = true;
+            }
+            m_tasksAvailable.notify_all();
+
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t GetThreadCount() const { return m_workers.size() + 1; }
+
+        // Calls task(i) for every i in [0, taskCount) on the worker threads and the calling thread, in no particular
+        // order, and returns once all calls are done. Only one thread may call Run() at a time.
+        void Run(size_t taskCount, const std::function<void(size_t)>& task)
+        {
+            if (taskCount == 0)
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_task = &task;
+            m_taskCount = taskCount;
+            m_nextTask = 0;
+            m_finishedTaskCount = 0;
+            m_tasksAvailable.notify_all();
+
+            // The calling thread works too instead of just waiting.
+            while (TryRunNextTask(lock))
+            {
+            }
+
+            m_tasksFinished.wait(lock, [this]() { return m_finishedTaskCount == m_taskCount; });
+            m_task = nullptr;
+        }
+
+    private:
+        void WorkerLoop()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true)
+            {
+                m_tasksAvailable.wait(lock, [this]() { return m_isStopping || (m_task != nullptr && m_nextTask < m_taskCount); });
+                if (m_isStopping)
+                {
+                    return;
+                }
+
+                while (TryRunNextTask(lock))
+                {
+                }
+            }
+        }
+
+        // Runs the next task of the current loop, returns false if there is none left. Called with m_mutex locked.
+        bool TryRunNextTask(std::unique_lock<std::mutex>& lock)
+        {
+            if (m_task == nullptr || m_nextTask == m_taskCount)
+            {
+                return false;
+            }
+
+            const auto& task = *m_task;
+            size_t taskIndex = m_nextTask++;
+
+            lock.unlock();
+            task(taskIndex);
+            lock.lock();
+
+            if (++m_finishedTaskCount == m_taskCount)
+            {
+                m_tasksFinished.notify_one();
+            }
+            return true;
+        }
+
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_tasksAvailable;
+        std::condition_variable m_tasksFinished;
+
+        const std::function<void(size_t)>* m_task = nullptr;
+        size_t m_taskCount = 0;
+        size_t m_nextTask = 0;
+        size_t m_finishedTaskCount = 0;
+        bool m_isStopping = false;
+    };
+}
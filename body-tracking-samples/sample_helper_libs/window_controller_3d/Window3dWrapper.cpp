@@ -27,9 +27,10 @@ void Window3dWrapper::Create(
     const char* name,
     k4a_depth_mode_t depthMode,
     int windowWidth,
-    int windowHeight)
+    int windowHeight,
+    bool vsync)
 {
-    m_window3d.Create(name, true, windowWidth, windowHeight);
+    m_window3d.Create(name, true, windowWidth, windowHeight, false, vsync);
     m_window3d.SetMirrorMode(true);
 
     switch (depthMode)
@@ -72,66 +73,42 @@ void Window3dWrapper::Delete()
 {
     m_window3d.Delete();
 
-    if (m_transformationHandle != nullptr)
-    {
-        k4a_transformation_destroy(m_transformationHandle);
-        m_transformationHandle = nullptr;
-    }
-
-    if (m_pointCloudImage != nullptr)
-    {
-        k4a_image_release(m_pointCloudImage);
-        m_pointCloudImage = nullptr;
-    }
+    m_depthUnprojector.reset();
+    m_pointBuffer.reset();
 }
 
 void Window3dWrapper::UpdatePointClouds(k4a_image_t depthImage, std::vector<Color> pointCloudColors)
 {
+    EXIT_IF(m_depthUnprojector == nullptr, "Point clouds need a window created with the sensor calibration!");
     m_pointCloudUpdated = true;
-    VERIFY(k4a_transformation_depth_image_to_point_cloud(m_transformationHandle,
-        depthImage,
-        K4A_CALIBRATION_TYPE_DEPTH,
-        m_pointCloudImage), "Transform depth image to point clouds failed!");
-
-    int width = k4a_image_get_width_pixels(m_pointCloudImage);
-    int height = k4a_image_get_height_pixels(m_pointCloudImage);
 
-    int16_t* pointCloudImageBuffer = (int16_t*)k4a_image_get_buffer(m_pointCloudImage);
+    // The points are unprojected straight from the depth image with the cached table, in meters
+    const Samples::PointCloudArrays& points = m_pointBuffer->GetArrays();
+    size_t pointCount = m_depthUnprojector->Unproject(
+        reinterpret_cast<const uint16_t*>(k4a_image_get_buffer(depthImage)),
+        Samples::PointCloudRegion(),
+        points);
 
-    for (int h = 0; h < height; h++)
+    m_pointClouds.reserve(m_pointClouds.size() + pointCount);
+    for (size_t i = 0; i < pointCount; i++)
     {
-        for (int w = 0; w < width; w++)
+        uint32_t pixelIndex = points.PixelIndices[i];
+
+        linmath::vec4 color = { 0.8f, 0.8f, 0.8f, 0.6f };
+        if (pointCloudColors.size() > 0)
         {
-            int pixelIndex = h * width + w;
-            k4a_float3_t position = {
-                static_cast<float>(pointCloudImageBuffer[3 * pixelIndex + 0]),
-                static_cast<float>(pointCloudImageBuffer[3 * pixelIndex + 1]),
-                static_cast<float>(pointCloudImageBuffer[3 * pixelIndex + 2]) };
-
-            // When the point cloud is invalid, the z-depth value is 0.
-            if (position.v[2] == 0)
-            {
-                continue;
-            }
-
-            linmath::vec4 color = { 0.8f, 0.8f, 0.8f, 0.6f };
-            linmath::ivec2 pixelLocation = { w, h };
-
-            if (pointCloudColors.size() > 0)
-            {
-                BlendBodyColor(color, pointCloudColors[pixelIndex]);
-            }
-
-            linmath::vec3 positionInMeter;
-            ConvertMillimeterToMeter(position, positionInMeter);
-            Visualization::PointCloudVertex pointCloud;
-            linmath::vec3_copy(pointCloud.Position, positionInMeter);
-            linmath::vec4_copy(pointCloud.Color, color);
-            pointCloud.PixelLocation[0] = pixelLocation[0];
-            pointCloud.PixelLocation[1] = pixelLocation[1];
-
-            m_pointClouds.push_back(pointCloud);
+            BlendBodyColor(color, pointCloudColors[pixelIndex]);
         }
+
+        Visualization::PointCloudVertex pointCloud;
+        pointCloud.Position[0] = points.X[i];
+        pointCloud.Position[1] = points.Y[i];
+        pointCloud.Position[2] = points.Z[i];
+        linmath::vec4_copy(pointCloud.Color, color);
+        pointCloud.PixelLocation[0] = static_cast<int>(pixelIndex % m_depthWidth);
+        pointCloud.PixelLocation[1] = static_cast<int>(pixelIndex / m_depthWidth);
+
+        m_pointClouds.push_back(pointCloud);
     }
 
     UpdateDepthBuffer(depthImage);
@@ -267,27 +244,16 @@ void Window3dWrapper::InitializeCalibration(const k4a_calibration_t& sensorCalib
     m_depthHeight = static_cast<uint32_t>(sensorCalibration.depth_camera_calibration.resolution_height);
 
     // Cache the 2D to 3D unprojection table
-    EXIT_IF(!CreateXYDepthTable(sensorCalibration), "Create XY Depth Table failed!");
+    m_depthUnprojector = std::make_unique<Samples::DepthUnprojector>(sensorCalibration);
+    m_pointBuffer = std::make_unique<Samples::AlignedPointCloudBuffer>(
+        m_depthUnprojector->GetMaxPointCount(Samples::PointCloudRegion()),
+        true);  // The pixel index of every point gives its color and pixel location
+
     m_window3d.InitializePointCloudRenderer(
         true,   // Enable point cloud shading for better visualization effect
-        reinterpret_cast<float*>(m_xyDepthTable.data()),
+        reinterpret_cast<const float*>(m_depthUnprojector->GetXyTable().data()),
         m_depthWidth,
         m_depthHeight);
-
-    // Create transformation handle
-    if (m_transformationHandle == nullptr)
-    {
-        m_transformationHandle = k4a_transformation_create(&sensorCalibration);
-
-        if (m_pointCloudImage == nullptr)
-        {
-            VERIFY(k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM,
-                m_depthWidth,
-                m_depthHeight,
-                m_depthWidth * 3 * (int)sizeof(int16_t),
-                &m_pointCloudImage), "Create Point Cloud Image failed!");
-        }
-    }
 }
 
 void Window3dWrapper::BlendBodyColor(linmath::vec4 color, Color bodyColor)
@@ -307,51 +273,3 @@ void Window3dWrapper::UpdateDepthBuffer(k4a_image_t depthFrame)
     uint16_t* depthFrameBuffer = (uint16_t*)k4a_image_get_buffer(depthFrame);
     m_depthBuffer.assign(depthFrameBuffer, depthFrameBuffer + width * height);
 }
-
-bool Window3dWrapper::CreateXYDepthTable(const k4a_calibration_t & sensorCalibration)
-{
-    int width = sensorCalibration.depth_camera_calibration.resolution_width;
-    int height = sensorCalibration.depth_camera_calibration.resolution_height;
-
-    m_xyDepthTable.resize(width * height);
-
-    auto xyTablePtr = m_xyDepthTable.begin();
-
-    k4a_float3_t pt3;
-    for (int h = 0; h < height; h++)
-    {
-        for (int w = 0; w < width; w++)
-        {
-            k4a_float2_t pt = { static_cast<float>(w), static_cast<float>(h) };
-            int valid = 0;
-            k4a_result_t result = k4a_calibration_2d_to_3d(&sensorCalibration,
-                &pt,
-                1.f,
-                K4A_CALIBRATION_TYPE_DEPTH,
-                K4A_CALIBRATION_TYPE_DEPTH,
-                &pt3,
-                &valid);
-            if (result != K4A_RESULT_SUCCEEDED)
-            {
-                return false;
-            }
-
-            if (valid == 0)
-            {
-                // Set the invalid xy table to be (0, 0)
-                xyTablePtr->x = 0.f;
-                xyTablePtr->y = 0.f;
-            }
-            else
-            {
-                xyTablePtr->x = pt3.xyz.x;
-                xyTablePtr->y = pt3.xyz.y;
-            }
-
-            ++xyTablePtr;
-        }
-    }
-
-    return true;
-}
-
@@ -5,6 +5,9 @@
 
 #include <k4abttypes.h>
 #include <BodyTrackingHelpers.h>
+#include <DepthUnprojector.h>
+
+#include <memory>
 
 #include "WindowController3d.h"
 
@@ -15,12 +18,13 @@ class Window3dWrapper
 public:
     ~Window3dWrapper();
 
-    // Create Window3d wrapper without point cloud shading
+    // Create Window3d wrapper without point cloud shading. Without vsync, Render() does not wait for the display.
     void Create(
         const char* name,
         k4a_depth_mode_t depthMode,
         int windowWidth = -1,
-        int windowHeight = -1);
+        int windowHeight = -1,
+        bool vsync = true);
 
     // Create Window3d wrapper with point cloud shading
     void Create(
@@ -67,8 +71,6 @@ private:
 
     void UpdateDepthBuffer(k4a_image_t depthImage);
 
-    bool CreateXYDepthTable(const k4a_calibration_t& sensorCalibration);
-
 private:
     Visualization::WindowController3d m_window3d;
 
@@ -76,14 +78,10 @@ private:
     std::vector<uint16_t> m_depthBuffer;
     std::vector<Visualization::PointCloudVertex> m_pointClouds;
 
-    struct XY
-    {
-        float x;
-        float y;
-    };
-    std::vector<XY> m_xyDepthTable;
     uint32_t m_depthWidth = 0;
     uint32_t m_depthHeight = 0;
-    k4a_transformation_t m_transformationHandle = nullptr;
-    k4a_image_t m_pointCloudImage = nullptr;
+
+    // Unprojection table of the depth camera, shared by the point cloud conversion and the point cloud shading
+    std::unique_ptr<Samples::DepthUnprojector> m_depthUnprojector;
+    std::unique_ptr<Samples::AlignedPointCloudBuffer> m_pointBuffer;
 };
\ No newline at end of file
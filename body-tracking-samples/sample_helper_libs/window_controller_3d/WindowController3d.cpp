@@ -59,7 +59,7 @@ WindowController3d::WindowController3d()
     m_topViewControl.SetViewPoint(ViewPoint::TopView);
 }
 
-void WindowController3d::Create(const char* name, bool showWindow, int width, int height, bool fullscreen)
+void WindowController3d::Create(const char* name, bool showWindow, int width, int height, bool fullscreen, bool vsync)
 {
     CheckAssert(!m_initialized);
     m_initialized = true;
@@ -170,7 +170,9 @@ void WindowController3d::Create(const char* name, bool showWindow, int width, in
         exit(EXIT_FAILURE);
     }
 
-    glfwSwapInterval(showWindow ? 1 : 0);
+    // Without vsync, rendering the window does not wait for the display, e.g. for secondary windows rendered from the
+    // same loop as the main one.
+    glfwSwapInterval(showWindow && vsync ? 1 : 0);
 
     // Context Settings
     glEnable(GL_MULTISAMPLE);
@@ -46,7 +46,8 @@ namespace Visualization
             bool showWindow = true,
             int width = -1,
             int height = -1,
-            bool fullscreen = false);
+            bool fullscreen = false,
+            bool vsync = true);
 
         void Delete();
 